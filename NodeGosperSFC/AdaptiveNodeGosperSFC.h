@@ -0,0 +1,205 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <vector>
+#include <algorithm>
+#include "NodeGosperSFC.h"
+
+//Leaf cell of the adaptive Node-Gosper tree
+struct AdaptiveCell
+{
+	CODE code; //Code of the cell, digits of deeper levels are zero
+	uint depth; //Number of code digits defining the cell (0 = root)
+	uint first; //Index of the first point of the cell along SFC
+	uint num; //Number of points in the cell
+};
+
+/*
+Adaptive Node-Gosper SFC class
+
+A cell is subdivided only while it holds more than maxPointsPerCell points. Codes of points are \
+truncated to the digits of their leaf cell, the deeper digits are zero, so the array of codes keeps \
+the order of the Node-Gosper SFC.
+*/
+class AdaptiveNodeGosperSFC : public NodeGosperSFC {
+private:
+	uint maxPointsPerCell; //Max. number of points in a cell which is not subdivided
+	unsigned char * depths; //Array of code depths along SFC
+	vector<AdaptiveCell> cells; //Leaf cells in the SFC order
+
+public:
+	/*
+	_level - index of the deepest allowed level of recursion
+	_maxPointsPerCell - max. number of points in a leaf cell above the deepest level
+	*/
+	AdaptiveNodeGosperSFC(uint _level, PointCloud<2> * _pc, NodeGosperSFC_Type _type, uint _maxPointsPerCell) : NodeGosperSFC(_level, _pc, _type) {
+		maxPointsPerCell = _maxPointsPerCell;
+		depths = new unsigned char[GetPointNum()];
+	}
+
+	virtual ~AdaptiveNodeGosperSFC() {
+		delete[] depths;
+		depths = NULL;
+	}
+	/*
+	Constructs SFC and the adaptive tree
+	*/
+	virtual void ConstructSFC();
+	/*
+	Extends the frame upward by k levels, depths of codes and cells are increased by k
+	*/
+	virtual void ExtendLevels(uint k);
+	/*
+	Extends the frame to cover the points appended to the point cloud and rebuilds the adaptive tree \
+	of all points (truncated codes do not hold the digits needed to subdivide old cells, so they are not merged)
+	*/
+	virtual void UpdateSFC();
+	/*
+	Returns array of code depths (number of code digits of the leaf cell of each point along SFC)
+	*/
+	unsigned char * GetDepths() { return depths; }
+	/*
+	Returns number of leaf cells
+	*/
+	uint GetCellNum() { return (uint)cells.size(); }
+	/*
+	Returns array of leaf cells in the SFC order
+	*/
+	const AdaptiveCell * GetCells() { return cells.data(); }
+	/*
+	Returns code mask keeping the digits of the given depth
+	*/
+	inline CODE GetDepthMask(uint depth) {
+		uint bits = GetBitShift() * (GetLevel() + 1 - depth);
+		return ~((((CODE)1) << bits) - 1);
+	}
+
+private:
+	/*
+	Collects leaf cells as runs of equal codes and depths
+	*/
+	void CollectCells();
+	/*
+	Subdivides the sorted run of points [first, end) defining a cell of the given depth
+	*/
+	void Subdivide(uint first, uint end, uint depth);
+};
+
+void AdaptiveNodeGosperSFC::ConstructSFC()
+{
+	NodeGosperSFC::ConstructSFC();
+
+	cells.clear();
+	if (GetPointNum() > 0)
+		Subdivide(0, GetPointNum(), 0);
+}
+
+void AdaptiveNodeGosperSFC::ExtendLevels(uint k)
+{
+	NodeGosperSFC::ExtendLevels(k);
+	if (k == 0)
+		return;
+
+	//Odd extension of the precise pattern reverses the sorted arrays
+	if (GetType() == NodeGosperSFC_Precise && (k % 2)) {
+		reverse(depths, depths + GetCodeNum());
+	}
+
+	//Zero digits below the leaf cells may be rewritten by the extension
+	CODE * codes = GetCodes();
+	for (uint i = 0; i < GetCodeNum(); i++) {
+		depths[i] += (unsigned char)k;
+		codes[i] &= GetDepthMask(depths[i]);
+	}
+
+	CollectCells();
+}
+
+void AdaptiveNodeGosperSFC::UpdateSFC()
+{
+	if (GetPointNum() <= GetCodeNum())
+		return;
+
+	AddLevels(AppendedLevels());
+	delete[] depths;
+	depths = new unsigned char[GetPointNum()];
+	ConstructSFC();
+}
+
+void AdaptiveNodeGosperSFC::CollectCells()
+{
+	CODE * codes = GetCodes();
+	cells.clear();
+
+	AdaptiveCell cell;
+	for (uint i = 0; i < GetCodeNum(); i++) {
+		if (i == 0 || codes[i] != cell.code || depths[i] != cell.depth) {
+			if (i > 0)
+				cells.push_back(cell);
+			cell.code = codes[i];
+			cell.depth = depths[i];
+			cell.first = i;
+			cell.num = 0;
+		}
+		cell.num++;
+	}
+	if (GetCodeNum() > 0)
+		cells.push_back(cell);
+}
+
+void AdaptiveNodeGosperSFC::Subdivide(uint first, uint end, uint depth)
+{
+	CODE * codes = GetCodes();
+
+	//Leaf cell
+	if ((end - first) <= maxPointsPerCell || depth > GetLevel()) {
+		CODE mask = GetDepthMask(depth);
+		for (uint i = first; i < end; i++) {
+			codes[i] &= mask;
+			depths[i] = (unsigned char)depth;
+		}
+
+		AdaptiveCell cell;
+		cell.code = codes[first];
+		cell.depth = depth;
+		cell.first = first;
+		cell.num = end - first;
+		cells.push_back(cell);
+		return;
+	}
+
+	//Sorted codes sharing the digit of the next level form contiguous runs
+	CODE lowBits = ~GetDepthMask(depth + 1);
+	uint b = first, e;
+	while (b < end) {
+		e = (uint)(upper_bound(codes + b, codes + end, codes[b] | lowBits) - codes);
+		Subdivide(b, e, depth + 1);
+		b = e;
+	}
+}
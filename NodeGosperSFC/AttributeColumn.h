@@ -0,0 +1,235 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include "common.h"
+#include "Parallel.h"
+
+//Type of values of an attribute (the order of PlyType)
+enum AttributeType {
+	AttributeType_Int8,
+	AttributeType_UInt8,
+	AttributeType_Int16,
+	AttributeType_UInt16,
+	AttributeType_Int32,
+	AttributeType_UInt32,
+	AttributeType_Float32,
+	AttributeType_Float64
+};
+
+//Column of a text point file
+struct TextColumn
+{
+	string name; //"x", "y" or "z" for coordinates, empty for a skipped column, otherwise name of an attribute
+	AttributeType type; //Type of the attribute
+
+	TextColumn(string _name = "", AttributeType _type = AttributeType_Float64) : name(_name), type(_type) {}
+	TextColumn(const char * _name, AttributeType _type = AttributeType_Float64) : name(_name), type(_type) {}
+};
+
+/*
+Typed column of values of one attribute of points (e.g. intensity, time or class)
+
+Values are stored in the original order of points. After the construction of an SFC the column \
+is copied into the order of points along the SFC by one gather pass over the indices, \
+blocks of the pass run in parallel and each block is a tight loop specialized for the type.
+*/
+class AttributeColumn
+{
+private:
+	string name; //Name of the attribute
+	AttributeType type; //Type of values
+	uint num; //Number of values
+	vector<char> values; //Values in the original order of points
+	vector<char> ordered; //Values in the order of points along SFC (empty if not ordered)
+
+	/*
+	Copies values of the given indices from src to dst[first] - dst[last - 1]
+	*/
+	template <class T> static void Gather(const char * src, char * dst, const uint * indices, uint first, uint last);
+	/*
+	Returns value converted to the type T (integers are rounded and clamped to the range of T)
+	*/
+	template <class T> static T Convert(double v);
+	/*
+	Returns the value stored at p
+	*/
+	double Read(const char * p) const;
+
+public:
+	/*
+	_name - name of the attribute
+	_type - type of values
+	n - number of values (zeros)
+	*/
+	AttributeColumn(string _name, AttributeType _type, uint n = 0) : name(_name), type(_type), num(0) { Resize(n); }
+
+	/*
+	Returns size of a value of the given type in bytes
+	*/
+	static uint TypeSize(AttributeType type) {
+		static const uint sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+		return sizes[type];
+	}
+	/*
+	Returns name of the attribute
+	*/
+	const string & GetName() const { return name; }
+	/*
+	Returns type of values
+	*/
+	AttributeType GetType() const { return type; }
+	/*
+	Returns number of values
+	*/
+	uint GetNum() const { return num; }
+	/*
+	Changes number of values, new values are zeros. The order along SFC is dropped.
+	*/
+	void Resize(uint n);
+	/*
+	Sets the i-th value converted to the type of the column
+	*/
+	void Set(uint i, double v);
+	/*
+	Returns the i-th value in the original order of points
+	*/
+	double Get(uint i) const { return Read(&values[(size_t)i * TypeSize(type)]); }
+	/*
+	Returns the i-th value in the order of points along SFC (the column has to be ordered)
+	*/
+	double GetOrdered(uint i) const { return Read(&ordered[(size_t)i * TypeSize(type)]); }
+	/*
+	Returns array of values in the original order of points
+	*/
+	char * GetData() { return (num ? &values[0] : NULL); }
+	/*
+	Returns array of values in the order of points along SFC (NULL if the column is not ordered)
+	*/
+	const char * GetOrderedData() const { return (ordered.empty() ? NULL : &ordered[0]); }
+	/*
+	Returns true if the values are ordered along SFC
+	*/
+	bool IsOrdered() const { return !ordered.empty() || num == 0; }
+	/*
+	Copies the values into the order of points along SFC
+
+	indices - indices of points along SFC
+	n - number of indices (number of values)
+	threads - number of threads (0 = all hardware threads)
+	*/
+	void Order(const uint * indices, uint n, uint threads = 0);
+};
+
+template <class T> inline void AttributeColumn::Gather(const char * src, char * dst, const uint * indices, const uint first, const uint last)
+{
+	const T * s = (const T *)src;
+	T * d = (T *)dst;
+	for (uint i = first; i < last; i++) {
+		d[i] = s[indices[i]];
+	}
+}
+
+template <class T> inline T AttributeColumn::Convert(double v)
+{
+	if (!numeric_limits<T>::is_integer)
+		return (T)v;
+	v = floor(v + 0.5);
+	if (!(v > (double)numeric_limits<T>::min()))
+		return numeric_limits<T>::min();
+	if (v >= (double)numeric_limits<T>::max())
+		return numeric_limits<T>::max();
+	return (T)v;
+}
+
+inline double AttributeColumn::Read(const char * p) const
+{
+	switch (type) {
+	case AttributeType_Int8: return (double)*(const signed char *)p;
+	case AttributeType_UInt8: return (double)*(const unsigned char *)p;
+	case AttributeType_Int16: { short v; memcpy(&v, p, 2); return (double)v; }
+	case AttributeType_UInt16: { unsigned short v; memcpy(&v, p, 2); return (double)v; }
+	case AttributeType_Int32: { int v; memcpy(&v, p, 4); return (double)v; }
+	case AttributeType_UInt32: { uint v; memcpy(&v, p, 4); return (double)v; }
+	case AttributeType_Float32: { float v; memcpy(&v, p, 4); return (double)v; }
+	default: { double v; memcpy(&v, p, 8); return v; }
+	}
+}
+
+inline void AttributeColumn::Resize(const uint n)
+{
+	values.resize((size_t)n * TypeSize(type), 0);
+	num = n;
+	ordered.clear();
+	ordered.shrink_to_fit();
+}
+
+inline void AttributeColumn::Set(const uint i, const double v)
+{
+	char * p = &values[(size_t)i * TypeSize(type)];
+	switch (type) {
+	case AttributeType_Int8: { signed char c = Convert<signed char>(v); memcpy(p, &c, 1); break; }
+	case AttributeType_UInt8: { unsigned char c = Convert<unsigned char>(v); memcpy(p, &c, 1); break; }
+	case AttributeType_Int16: { short c = Convert<short>(v); memcpy(p, &c, 2); break; }
+	case AttributeType_UInt16: { unsigned short c = Convert<unsigned short>(v); memcpy(p, &c, 2); break; }
+	case AttributeType_Int32: { int c = Convert<int>(v); memcpy(p, &c, 4); break; }
+	case AttributeType_UInt32: { uint c = Convert<uint>(v); memcpy(p, &c, 4); break; }
+	case AttributeType_Float32: { float c = Convert<float>(v); memcpy(p, &c, 4); break; }
+	default: memcpy(p, &v, 8);
+	}
+}
+
+inline void AttributeColumn::Order(const uint * indices, const uint n, const uint threads)
+{
+	const uint size = TypeSize(type);
+	ordered.resize((size_t)n * size);
+	if (n == 0)
+		return;
+
+	//Blocks of the gather pass, the random reads are spread over threads
+	const uint blockSize = 1 << 16;
+	const uint blockNum = (n + blockSize - 1) / blockSize;
+	const char * src = &values[0];
+	char * dst = &ordered[0];
+	ParallelFor(blockNum, [&](uint b) {
+		const uint first = b * blockSize;
+		const uint last = (n - first < blockSize ? n : first + blockSize);
+		switch (size) {
+		case 1: Gather<unsigned char>(src, dst, indices, first, last); break;
+		case 2: Gather<unsigned short>(src, dst, indices, first, last); break;
+		case 4: Gather<uint>(src, dst, indices, first, last); break;
+		default: Gather<unsigned long long>(src, dst, indices, first, last);
+		}
+	}, threads);
+}
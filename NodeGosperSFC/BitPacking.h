@@ -0,0 +1,160 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <vector>
+#include "common.h"
+
+typedef unsigned long long WORD64;
+
+/*
+Returns number of bits needed to represent v
+*/
+inline uint BitWidth(WORD64 v)
+{
+	uint w = 0;
+	while (v) {
+		w++;
+		v >>= 1;
+	}
+	return w;
+}
+
+/*
+Returns width bits at the bit position pos of an array of words (width 0 - 64)
+*/
+inline WORD64 ReadBits(const WORD64 * words, size_t pos, uint width)
+{
+	if (width == 0)
+		return 0;
+
+	const WORD64 * w = words + (pos >> 6);
+	uint shift = (uint)(pos & 63);
+	WORD64 v = w[0] >> shift;
+	if (shift + width > 64)
+		v |= w[1] << (64 - shift);
+	return (width == 64 ? v : v & ((((WORD64)1) << width) - 1));
+}
+
+/*
+Writer of bits appended to an array of words
+*/
+class BitWriter
+{
+private:
+	vector<WORD64> & words; //Output words
+	size_t pos; //Number of written bits
+
+public:
+	BitWriter(vector<WORD64> & _words) : words(_words) { pos = words.size() * 64; }
+
+	/*
+	Appends the lowest width bits of v (width 0 - 64)
+	*/
+	inline void Write(WORD64 v, uint width) {
+		if (width == 0)
+			return;
+		if (width < 64)
+			v &= (((WORD64)1) << width) - 1;
+
+		uint shift = (uint)(pos & 63);
+		if (shift == 0)
+			words.push_back(0);
+		words.back() |= v << shift;
+		if (shift + width > 64)
+			words.push_back(v >> (64 - shift));
+		pos += width;
+	}
+	/*
+	Appends count zero bits followed by a one bit (unary code)
+	*/
+	inline void WriteUnary(uint count) {
+		for (; count >= 32; count -= 32)
+			Write(0, 32);
+		Write(((WORD64)1) << count, count + 1);
+	}
+	/*
+	Pads the stream to whole words
+	*/
+	inline void Flush() {
+		pos = words.size() * 64;
+	}
+	/*
+	Returns number of written bits
+	*/
+	inline size_t GetBitNum() { return pos; }
+};
+
+/*
+Sequential reader of bits from an array of words
+*/
+class BitReader
+{
+private:
+	const WORD64 * words; //Input words
+	size_t pos; //Bit position
+
+public:
+	BitReader(const WORD64 * _words, size_t _pos = 0) : words(_words), pos(_pos) {}
+
+	/*
+	Reads width bits (width 0 - 64)
+	*/
+	inline WORD64 Read(uint width) {
+		WORD64 v = ReadBits(words, pos, width);
+		pos += width;
+		return v;
+	}
+	/*
+	Reads a unary code, returns number of zero bits before the one bit. \
+	Reading stops behind limit zero bits (limit + 1 is returned then).
+	*/
+	inline uint ReadUnary(uint limit) {
+		uint count = 0;
+		while (count <= limit) {
+			WORD64 w = words[pos >> 6] >> (pos & 63);
+			if (w) {
+				uint z = 0;
+				while (!(w & 1)) {
+					w >>= 1;
+					z++;
+				}
+				pos += z + 1;
+				return count + z;
+			}
+			uint skip = 64 - (uint)(pos & 63);
+			count += skip;
+			pos += skip;
+		}
+		return limit + 1;
+	}
+	/*
+	Returns bit position
+	*/
+	inline size_t GetPosition() { return pos; }
+};
@@ -0,0 +1,273 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstdio>
+#include <cstring>
+#include "BitPacking.h"
+
+#define CODE_BLOCK_SIZE 128 //Number of codes in a compressed block
+
+/*
+Block-compressed array of sorted codes
+
+Codes are split into blocks of CODE_BLOCK_SIZE codes. The first code of each block is stored \
+in the skip index of bases, the other codes as deltas from their predecessors bit-packed \
+with the width of the largest delta of the block. Equal and close codes of the same cells \
+need only a few bits per code.
+
+Serialized form (words of 8 bytes): number of codes, number of blocks, number of packed words, \
+bases, bit offsets of blocks, widths of blocks (bytes padded to whole words), packed deltas.
+*/
+class CompressedCodes
+{
+private:
+	uint num; //Number of codes
+	uint blockNum; //Number of blocks
+	size_t wordNum; //Number of words of packed deltas
+
+	const CODE * bases; //First code of each block (skip index)
+	const WORD64 * offsets; //Bit offset of packed deltas of each block
+	const unsigned char * widths; //Bit width of deltas of each block
+	const WORD64 * words; //Packed deltas
+
+	vector<CODE> ownBases; //Storage of the arrays of compressed codes (empty if attached to external memory)
+	vector<WORD64> ownOffsets;
+	vector<unsigned char> ownWidths;
+	vector<WORD64> ownWords;
+
+	/*
+	Returns size of the array of widths padded to whole words in bytes
+	*/
+	inline size_t WidthsSize() const { return (blockNum + 7) / 8 * 8; }
+
+public:
+	CompressedCodes() : num(0), blockNum(0), wordNum(0), bases(NULL), offsets(NULL), widths(NULL), words(NULL) {}
+
+	/*
+	Compresses an array of n codes (sorted codes are expected for LowerBound)
+	*/
+	void Compress(const CODE * codes, uint n);
+	/*
+	Uses compressed codes serialized in external memory (e.g. a mapped file) without copying. \
+	Returns false if the data are not valid.
+	*/
+	bool Attach(const char * data, size_t size);
+	/*
+	Returns number of codes
+	*/
+	inline uint GetNum() const { return num; }
+	/*
+	Returns i-th code
+	*/
+	CODE Get(uint i) const;
+	/*
+	Decompresses n codes starting at the index first
+	*/
+	void Decode(uint first, uint n, CODE * out) const;
+	/*
+	Returns index of the first code which is not less than code (number of codes if there is none)
+	*/
+	uint LowerBound(CODE code) const;
+	/*
+	Returns size of the serialized compressed codes in bytes
+	*/
+	size_t GetSize() const {
+		return 3 * sizeof(WORD64) + blockNum * (sizeof(CODE) + sizeof(WORD64)) + WidthsSize() + wordNum * sizeof(WORD64);
+	}
+	/*
+	Writes serialized compressed codes to a file, returns false on error
+	*/
+	bool Write(FILE * f) const;
+	/*
+	Writes serialized compressed codes to memory of GetSize() bytes
+	*/
+	void Write(char * out) const;
+};
+
+void CompressedCodes::Compress(const CODE * codes, uint n)
+{
+	num = n;
+	blockNum = (n + CODE_BLOCK_SIZE - 1) / CODE_BLOCK_SIZE;
+	ownBases.resize(blockNum);
+	ownOffsets.resize(blockNum);
+	ownWidths.resize(WidthsSize());
+	ownWords.clear();
+
+	BitWriter writer(ownWords);
+	for (uint b = 0; b < blockNum; b++) {
+		const uint first = b * CODE_BLOCK_SIZE;
+		const uint last = (first + CODE_BLOCK_SIZE < n ? first + CODE_BLOCK_SIZE : n);
+
+		//Width of the largest delta of the block
+		WORD64 maxDelta = 0;
+		for (uint i = first + 1; i < last; i++) {
+			WORD64 delta = codes[i] - codes[i - 1];
+			maxDelta = (delta > maxDelta ? delta : maxDelta);
+		}
+		const uint width = BitWidth(maxDelta);
+
+		ownBases[b] = codes[first];
+		ownOffsets[b] = writer.GetBitNum();
+		ownWidths[b] = (unsigned char)width;
+		for (uint i = first + 1; i < last; i++) {
+			writer.Write(codes[i] - codes[i - 1], width);
+		}
+	}
+
+	wordNum = ownWords.size();
+	bases = (blockNum ? &ownBases[0] : NULL);
+	offsets = (blockNum ? &ownOffsets[0] : NULL);
+	widths = (blockNum ? &ownWidths[0] : NULL);
+	words = (wordNum ? &ownWords[0] : NULL);
+}
+
+bool CompressedCodes::Attach(const char * data, size_t size)
+{
+	if (size < 3 * sizeof(WORD64))
+		return false;
+
+	const WORD64 * counts = (const WORD64 *)data;
+	if (counts[0] > 0xFFFFFFFFULL || counts[1] != (counts[0] + CODE_BLOCK_SIZE - 1) / CODE_BLOCK_SIZE)
+		return false;
+
+	ownBases.clear();
+	ownOffsets.clear();
+	ownWidths.clear();
+	ownWords.clear();
+	num = (uint)counts[0];
+	blockNum = (uint)counts[1];
+	wordNum = (size_t)counts[2];
+	if (counts[2] > size / sizeof(WORD64) || GetSize() != size)
+		return false;
+
+	bases = (const CODE *)(data + 3 * sizeof(WORD64));
+	offsets = (const WORD64 *)(bases + blockNum);
+	widths = (const unsigned char *)(offsets + blockNum);
+	words = (const WORD64 *)(widths + WidthsSize());
+
+	//Packed deltas of all blocks have to lie inside the data
+	for (uint b = 0; b < blockNum; b++) {
+		const WORD64 deltaNum = (b + 1 < blockNum ? CODE_BLOCK_SIZE : num - b * CODE_BLOCK_SIZE) - 1;
+		if (widths[b] > 64 || offsets[b] > wordNum * 64 || deltaNum * widths[b] > wordNum * 64 - offsets[b])
+			return false;
+	}
+	return true;
+}
+
+CODE CompressedCodes::Get(uint i) const
+{
+	const uint b = i / CODE_BLOCK_SIZE;
+	const uint width = widths[b];
+	CODE code = bases[b];
+	if (width) {
+		size_t pos = (size_t)offsets[b];
+		for (uint j = i % CODE_BLOCK_SIZE; j > 0; j--, pos += width) {
+			code += ReadBits(words, pos, width);
+		}
+	}
+	return code;
+}
+
+void CompressedCodes::Decode(uint first, uint n, CODE * out) const
+{
+	uint i = first;
+	const uint end = first + n;
+	while (i < end) {
+		const uint b = i / CODE_BLOCK_SIZE;
+		const uint width = widths[b];
+		const uint blockEnd = ((b + 1) * CODE_BLOCK_SIZE < end ? (b + 1) * CODE_BLOCK_SIZE : end);
+
+		//Codes of the block preceding the range are skipped
+		CODE code = bases[b];
+		BitReader reader(words, (size_t)offsets[b]);
+		for (uint j = b * CODE_BLOCK_SIZE; j < i; j++) {
+			code += reader.Read(width);
+		}
+		*out++ = code;
+		for (i++; i < blockEnd; i++) {
+			code += reader.Read(width);
+			*out++ = code;
+		}
+	}
+}
+
+uint CompressedCodes::LowerBound(CODE code) const
+{
+	//First block whose base is not less than code
+	uint lo = 0, hi = blockNum;
+	while (lo < hi) {
+		uint mid = (lo + hi) / 2;
+		if (bases[mid] < code)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == 0)
+		return 0;
+
+	//The code is inside the previous block or at the beginning of the found one
+	const uint b = lo - 1;
+	const uint width = widths[b];
+	const uint blockEnd = (lo * CODE_BLOCK_SIZE < num ? lo * CODE_BLOCK_SIZE : num);
+	CODE c = bases[b];
+	BitReader reader(words, (size_t)offsets[b]);
+	for (uint i = b * CODE_BLOCK_SIZE + 1; i < blockEnd; i++) {
+		c += reader.Read(width);
+		if (c >= code)
+			return i;
+	}
+	return blockEnd;
+}
+
+bool CompressedCodes::Write(FILE * f) const
+{
+	const WORD64 counts[3] = { num, blockNum, wordNum };
+	return fwrite(counts, sizeof(counts), 1, f) == 1 &&
+		(blockNum == 0 || fwrite(bases, blockNum * sizeof(CODE), 1, f) == 1) &&
+		(blockNum == 0 || fwrite(offsets, blockNum * sizeof(WORD64), 1, f) == 1) &&
+		(blockNum == 0 || fwrite(widths, WidthsSize(), 1, f) == 1) &&
+		(wordNum == 0 || fwrite(words, wordNum * sizeof(WORD64), 1, f) == 1);
+}
+
+void CompressedCodes::Write(char * out) const
+{
+	const WORD64 counts[3] = { num, blockNum, wordNum };
+	memcpy(out, counts, sizeof(counts));
+	out += sizeof(counts);
+	if (blockNum) {
+		memcpy(out, bases, blockNum * sizeof(CODE));
+		out += blockNum * sizeof(CODE);
+		memcpy(out, offsets, blockNum * sizeof(WORD64));
+		out += blockNum * sizeof(WORD64);
+		memcpy(out, widths, WidthsSize());
+		out += WidthsSize();
+	}
+	if (wordNum)
+		memcpy(out, words, wordNum * sizeof(WORD64));
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <malloc.h>
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+#define DIRECT_IO_ALIGNMENT 4096 //Alignment of buffers, sizes and offsets of direct I/O
+
+/*
+Returns a buffer aligned to DIRECT_IO_ALIGNMENT (released by FreeAligned)
+*/
+inline char * AllocAligned(size_t size)
+{
+#ifdef _WIN32
+	return (char *)_aligned_malloc(size, DIRECT_IO_ALIGNMENT);
+#else
+	void * ptr = NULL;
+	return (posix_memalign(&ptr, DIRECT_IO_ALIGNMENT, size) == 0 ? (char *)ptr : NULL);
+#endif
+}
+
+inline void FreeAligned(char * ptr)
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+/*
+File read or written sequentially by direct I/O bypassing the page cache
+
+Buffers have to be aligned and sizes of reads and writes have to be multiples of DIRECT_IO_ALIGNMENT \
+(except of the last read). If the file system does not support direct I/O, buffered I/O is used.
+*/
+class DirectFile
+{
+private:
+#ifdef _WIN32
+	HANDLE file; //File handle
+#else
+	int fd; //File descriptor
+#endif
+
+public:
+	DirectFile();
+	virtual ~DirectFile();
+
+	/*
+	Opens the file, returns false on error
+
+	path - file address
+	write - the file is created (or truncated) for writing, otherwise it is opened for reading
+	*/
+	bool Open(string path, bool write);
+	/*
+	Closes the file
+	*/
+	void Close();
+	/*
+	Writes size bytes, returns false on error
+	*/
+	bool Write(const char * buffer, size_t size);
+	/*
+	Reads up to size bytes, returns number of read bytes (less than size at the end of the file, -1 on error)
+	*/
+	long long Read(char * buffer, size_t size);
+	/*
+	Sets position of the next read or write (aligned offset)
+	*/
+	bool Seek(unsigned long long offset);
+	/*
+	Sets size of the file (e.g. cuts the padding of the last block), returns false on error
+	*/
+	bool Truncate(unsigned long long size);
+	/*
+	Flushes written data to the disk, returns false on error
+	*/
+	bool Sync();
+};
+
+inline DirectFile::DirectFile()
+{
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+#else
+	fd = -1;
+#endif
+}
+
+inline DirectFile::~DirectFile()
+{
+	Close();
+}
+
+inline bool DirectFile::Open(string path, bool write)
+{
+	Close();
+#ifdef _WIN32
+	DWORD access = (write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ);
+	DWORD creation = (write ? CREATE_ALWAYS : OPEN_EXISTING);
+	file = CreateFileA(path.c_str(), access, FILE_SHARE_READ, NULL, creation, FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		file = CreateFileA(path.c_str(), access, FILE_SHARE_READ, NULL, creation, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	return file != INVALID_HANDLE_VALUE;
+#else
+	int flags = (write ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY);
+#ifdef O_DIRECT
+	fd = open(path.c_str(), flags | O_DIRECT, 0644);
+	if (fd < 0 && errno == EINVAL)
+#endif
+		fd = open(path.c_str(), flags, 0644);
+	return fd >= 0;
+#endif
+}
+
+inline void DirectFile::Close()
+{
+#ifdef _WIN32
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (fd >= 0)
+		close(fd);
+	fd = -1;
+#endif
+}
+
+inline bool DirectFile::Write(const char * buffer, size_t size)
+{
+	while (size > 0) {
+#ifdef _WIN32
+		DWORD chunk = (DWORD)(size < (1U << 30) ? size : (1U << 30)), written = 0;
+		if (!WriteFile(file, buffer, chunk, &written, NULL) || written == 0)
+			return false;
+#else
+		ssize_t written = write(fd, buffer, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+#ifdef O_DIRECT
+			//Direct I/O rejected by the file system, buffered I/O is used
+			if (errno == EINVAL && (fcntl(fd, F_GETFL) & O_DIRECT) && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT) == 0)
+				continue;
+#endif
+			return false;
+		}
+#endif
+		buffer += written;
+		size -= (size_t)written;
+	}
+	return true;
+}
+
+inline long long DirectFile::Read(char * buffer, size_t size)
+{
+	size_t total = 0;
+	while (total < size) {
+#ifdef _WIN32
+		DWORD chunk = (DWORD)(size - total < (1U << 30) ? size - total : (1U << 30)), read = 0;
+		if (!ReadFile(file, buffer + total, chunk, &read, NULL))
+			return -1;
+#else
+		ssize_t read = ::read(fd, buffer + total, size - total);
+		if (read < 0) {
+			if (errno == EINTR)
+				continue;
+#ifdef O_DIRECT
+			if (errno == EINVAL && (fcntl(fd, F_GETFL) & O_DIRECT) && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT) == 0)
+				continue;
+#endif
+			return -1;
+		}
+#endif
+		if (read == 0)
+			break;
+		total += (size_t)read;
+	}
+	return (long long)total;
+}
+
+inline bool DirectFile::Seek(unsigned long long offset)
+{
+#ifdef _WIN32
+	LARGE_INTEGER pos;
+	pos.QuadPart = (LONGLONG)offset;
+	return SetFilePointerEx(file, pos, NULL, FILE_BEGIN) != 0;
+#else
+	return lseek(fd, (off_t)offset, SEEK_SET) == (off_t)offset;
+#endif
+}
+
+inline bool DirectFile::Truncate(unsigned long long size)
+{
+#ifdef _WIN32
+	LARGE_INTEGER pos;
+	pos.QuadPart = (LONGLONG)size;
+	return SetFilePointerEx(file, pos, NULL, FILE_BEGIN) != 0 && SetEndOfFile(file) != 0;
+#else
+	return ftruncate(fd, (off_t)size) == 0;
+#endif
+}
+
+inline bool DirectFile::Sync()
+{
+#ifdef _WIN32
+	return FlushFileBuffers(file) != 0;
+#else
+	return fsync(fd) == 0;
+#endif
+}
+
+/*
+Replaces the file by the content atomically, returns false on error. The content is written to a temporary \
+file which is flushed to the disk and renamed over the file, so the file is either the old or the new one \
+after a crash.
+*/
+inline bool WriteDurableFile(string path, const string & content)
+{
+	const string tmpPath = path + ".tmp";
+	FILE * f = fopen(tmpPath.c_str(), "wb");
+	if (!f)
+		return false;
+	bool ok = (content.empty() || fwrite(content.data(), content.size(), 1, f) == 1) && fflush(f) == 0;
+#ifdef _WIN32
+	ok = ok && _commit(_fileno(f)) == 0;
+#else
+	ok = ok && fsync(fileno(f)) == 0;
+#endif
+	ok = (fclose(f) == 0) && ok;
+	if (!ok) {
+		remove(tmpPath.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	return MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	if (rename(tmpPath.c_str(), path.c_str()) != 0)
+		return false;
+
+	//The directory entry is flushed too
+	size_t slash = path.find_last_of('/');
+	int dir = open(slash == string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash).c_str()), O_RDONLY);
+	if (dir >= 0) {
+		fsync(dir);
+		close(dir);
+	}
+	return true;
+#endif
+}
@@ -0,0 +1,684 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstdio>
+#include <algorithm>
+#include <sstream>
+#include <fcntl.h>
+#include "StreamEncoder.h"
+#include "DirectFile.h"
+#include "RecordFile.h"
+
+#define MIN_MERGE_BUFFER (1 << 18) //Min. size of the buffer of a merged run in bytes
+#define EXTERNAL_SFC_MANIFEST "NGSFC_MANIFEST" //Magic word of the manifest of a build
+#define EXTERNAL_SFC_MANIFEST_VERSION 1
+
+static_assert(sizeof(StreamRecord) == RECORD_SIZE, "Unexpected size of StreamRecord");
+
+/*
+Returns true if record a precedes record b along SFC (equal codes are ordered by sequence numbers)
+*/
+inline bool RecordLess(const StreamRecord & a, const StreamRecord & b)
+{
+	return a.code < b.code || (a.code == b.code && a.seq < b.seq);
+}
+
+/*
+Loser tree selecting the least head of k sorted sequences by log2(k) comparisons
+
+L - less(i, j) comparing heads of sequences i and j (exhausted sequences are greater than all heads)
+*/
+template <class L> class LoserTree
+{
+private:
+	vector<uint> nodes; //Losers of matches in inner nodes, the winner in nodes[0]
+	uint k; //Number of sequences
+	L less; //Comparison of heads
+
+	/*
+	Plays matches of the subtree, returns its winner
+	*/
+	uint Build(uint node) {
+		if (node >= k)
+			return node - k;
+		uint w1 = Build(2 * node);
+		uint w2 = Build(2 * node + 1);
+		bool second = less(w2, w1);
+		nodes[node] = (second ? w1 : w2);
+		return (second ? w2 : w1);
+	}
+
+public:
+	LoserTree(uint _k, L _less) : nodes(_k > 0 ? _k : 1, 0), k(_k), less(_less) {
+		if (k > 0)
+			nodes[0] = Build(1);
+	}
+	/*
+	Returns index of the sequence with the least head
+	*/
+	uint Winner() { return nodes[0]; }
+	/*
+	Replays matches of the winner after the head of its sequence changed
+	*/
+	void Replay() {
+		uint w = nodes[0];
+		for (uint node = (w + k) / 2; node >= 1; node /= 2) {
+			if (less(nodes[node], w)) {
+				uint tmp = nodes[node];
+				nodes[node] = w;
+				w = tmp;
+			}
+		}
+		nodes[0] = w;
+	}
+};
+
+/*
+Sequential reader of a file of records by direct I/O
+*/
+class RunReader
+{
+private:
+	DirectFile file; //Read file
+	char * buffer; //Aligned buffer
+	size_t bufferSize; //Size of the buffer in bytes
+	const StreamRecord * cur, * end; //Records in the buffer
+	bool failed; //Read error occurred
+
+	void Fill() {
+		long long r = file.Read(buffer, bufferSize);
+		failed |= (r < 0);
+		cur = (const StreamRecord *)buffer;
+		end = cur + (r > 0 ? (size_t)r / sizeof(StreamRecord) : 0);
+	}
+
+public:
+	RunReader() : buffer(NULL), bufferSize(0), cur(NULL), end(NULL), failed(false) {}
+	virtual ~RunReader() { FreeAligned(buffer); }
+
+	/*
+	Opens the file and reads records from the aligned offset, returns false on error
+	*/
+	bool Open(string path, size_t _bufferSize, unsigned long long offset = 0) {
+		bufferSize = _bufferSize;
+		buffer = AllocAligned(bufferSize);
+		if (!buffer || !file.Open(path, false) || (offset > 0 && !file.Seek(offset)))
+			return false;
+		Fill();
+		return !failed;
+	}
+	/*
+	Returns the current record (NULL at the end)
+	*/
+	inline const StreamRecord * Head() { return (cur < end ? cur : NULL); }
+	/*
+	Moves to the next record
+	*/
+	inline void Advance() {
+		if (++cur == end)
+			Fill();
+	}
+	/*
+	Returns true if a read error occurred
+	*/
+	bool Failed() { return failed; }
+};
+
+/*
+Sequential writer of a file of records by direct I/O
+*/
+class RunWriter
+{
+private:
+	DirectFile file; //Written file
+	char * buffer; //Aligned buffer
+	size_t bufferSize; //Size of the buffer in bytes
+	size_t filled; //Bytes in the buffer
+	unsigned long long offset; //Offset of records in the file
+	unsigned long long count; //Number of written records
+	bool failed; //Write error occurred
+
+public:
+	RunWriter() : buffer(NULL), bufferSize(0), filled(0), offset(0), count(0), failed(false) {}
+	virtual ~RunWriter() { FreeAligned(buffer); }
+
+	/*
+	Creates the file, records are written from the aligned offset (the space before is reserved \
+	for a header), returns false on error
+	*/
+	bool Open(string path, size_t _bufferSize, unsigned long long _offset = 0) {
+		bufferSize = _bufferSize;
+		buffer = AllocAligned(bufferSize);
+		offset = _offset;
+		if (!buffer || !file.Open(path, true))
+			return false;
+		memset(buffer, 0, bufferSize);
+		for (unsigned long long o = 0; o < offset && !failed; o += DIRECT_IO_ALIGNMENT) {
+			failed = !file.Write(buffer, DIRECT_IO_ALIGNMENT);
+		}
+		return !failed;
+	}
+	/*
+	Appends a record
+	*/
+	inline void Append(const StreamRecord & r) {
+		memcpy(buffer + filled, &r, sizeof(StreamRecord));
+		filled += sizeof(StreamRecord);
+		count++;
+		if (filled == bufferSize) {
+			failed |= !file.Write(buffer, bufferSize);
+			filled = 0;
+		}
+	}
+	/*
+	Writes the rest of records and the header (of size up to the offset of records), returns false on error
+	*/
+	bool Finish(const void * header = NULL, size_t headerSize = 0) {
+		//The last block is padded and the padding is cut
+		size_t padded = (filled + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+		memset(buffer + filled, 0, padded - filled);
+		failed |= (padded > 0 && !file.Write(buffer, padded));
+		failed |= !file.Truncate(offset + count * sizeof(StreamRecord));
+
+		if (header && !failed) {
+			memset(buffer, 0, (size_t)offset);
+			memcpy(buffer, header, headerSize);
+			failed = !file.Seek(0) || !file.Write(buffer, (size_t)offset);
+		}
+		failed = failed || !file.Sync();
+		file.Close();
+		return !failed;
+	}
+	/*
+	Returns number of written records
+	*/
+	unsigned long long GetCount() { return count; }
+};
+
+/*
+Out-of-core construction of Node-Gosper SFC of point sets larger than the memory
+
+Points are read from a stream and hashed in a fixed frame (see StreamEncoder). Records of points \
+(code, sequence number, point) are collected up to the memory budget, sorted and spilled as sorted runs \
+to the working directory by direct I/O. The runs are merged by a loser tree into a record file \
+(see RecordFile.h), in several passes if the budget does not allow buffers of all runs.
+
+The budget is split into two buffers of records, one is sorted and spilled on a background thread \
+while the other one is filled by the pipeline of the encoder.
+
+The build is checkpointed to a manifest in the working directory (replaced atomically) after each \
+spilled run, after the end of input and after each merge of a group of runs, the runs are flushed \
+to the disk before. An interrupted or failed build keeps its runs and continues from the last \
+checkpoint by Resume, only the final merge is repeated as a whole.
+*/
+class ExternalSFCBuilder
+{
+private:
+	uint level; //Index of max. level of recursion
+	NodeGosperSFC_Type type; //Type of indexation pattern
+	Frame frame; //Frame of the SFC
+	size_t memoryBudget; //Max. size of buffers in bytes
+	string workDir; //Directory of sorted runs
+	uint threads; //Number of threads hashing points
+
+	vector<string> runs; //Paths of sorted runs waiting for merging
+	vector<unsigned long long> runSizes; //Numbers of records of the runs
+	uint nextRun; //Number of the next created run
+	unsigned long long coveredNum; //Number of input points in the runs
+	bool inputDone; //All input points are in the runs
+	unsigned long long pointNum; //Number of points of the last build
+	uint spilledRunNum; //Number of runs spilled by the last build
+	uint mergePassNum; //Number of merge passes of the last build
+
+	/*
+	Returns path of the r-th run
+	*/
+	string RunPath(uint r) { return workDir + "/run_" + to_string(r) + ".bin"; }
+	/*
+	Returns path of the manifest of the build
+	*/
+	string ManifestPath() { return workDir + "/manifest.txt"; }
+	/*
+	Resets the state to a new build
+	*/
+	void Reset();
+	/*
+	Writes the state of the build (parameters, consumed input, runs, merge progress) to the manifest, \
+	returns false on error
+	*/
+	bool SaveManifest();
+	/*
+	Loads the state of an interrupted build from the manifest, returns false if the manifest does not match \
+	the parameters of the builder or its runs are not complete (a missing manifest is a new build)
+	*/
+	bool LoadManifest();
+	/*
+	Hashes the rest of the input into spilled runs, returns false on error
+	*/
+	bool SpillInput(int fd);
+	/*
+	Spills the rest of the input (fd is not read if all points are in the runs) and merges the runs \
+	from the current state, returns false on error
+	*/
+	bool Construct(int fd, string outputPath);
+	/*
+	Opens a text point file for reading, returns -1 on error
+	*/
+	static int OpenInput(string path);
+	/*
+	Sorts records and writes them as a new run, returns false on error
+	*/
+	bool SpillRun(StreamRecord * records, size_t num);
+	/*
+	Merges sorted runs into a run or into the final record file, returns false on error
+	*/
+	bool MergeRuns(const vector<string> & inputs, string outputPath, bool final);
+	/*
+	Removes run files
+	*/
+	void RemoveRuns(const vector<string> & paths);
+
+public:
+	/*
+	_level - index of max. level of recursion
+	_type - type of indexation pattern
+	_frame - frame of the SFC (origin and radius which has to fit into the root)
+	_memoryBudget - max. size of buffers in bytes (at least 8 MB)
+	_workDir - existing directory of temporary sorted runs
+	_threads - number of threads hashing points (0 = all hardware threads)
+	*/
+	ExternalSFCBuilder(uint _level, NodeGosperSFC_Type _type, const Frame & _frame, size_t _memoryBudget, string _workDir, uint _threads = 0) {
+		level = _level;
+		type = _type;
+		frame = _frame;
+		memoryBudget = (_memoryBudget > (8 << 20) ? _memoryBudget : (8 << 20));
+		workDir = _workDir;
+		threads = _threads;
+		Reset();
+	}
+	/*
+	Reads points (whitespace-separated coordinates) from the file descriptor until the end of input \
+	and writes them along SFC to a record file, returns false on error
+	*/
+	bool Build(int fd, string outputPath);
+	/*
+	Reads points from a text point file, see Build(int, string)
+	*/
+	bool Build(string inputPath, string outputPath);
+	/*
+	Continues a build interrupted at a checkpoint in the working directory (a new build is started \
+	if there is no manifest), returns false on error. The same input has to be given from its beginning, \
+	points already in the runs are parsed but not hashed and sorted again.
+	*/
+	bool Resume(int fd, string outputPath);
+	/*
+	Continues a build reading points from a text point file, see Resume(int, string). \
+	The file is not read if all its points are in the runs.
+	*/
+	bool Resume(string inputPath, string outputPath);
+	/*
+	Returns number of points of the last build
+	*/
+	unsigned long long GetPointNum() { return pointNum; }
+	/*
+	Returns number of sorted runs spilled by the last build
+	*/
+	uint GetRunNum() { return spilledRunNum; }
+	/*
+	Returns number of merge passes of the last build (including the final one)
+	*/
+	uint GetMergePassNum() { return mergePassNum; }
+};
+
+void ExternalSFCBuilder::Reset()
+{
+	runs.clear();
+	runSizes.clear();
+	nextRun = 0;
+	coveredNum = 0;
+	inputDone = false;
+	pointNum = 0;
+	spilledRunNum = 0;
+	mergePassNum = 0;
+}
+
+bool ExternalSFCBuilder::SaveManifest()
+{
+	ostringstream out;
+	out.precision(17);
+	out << EXTERNAL_SFC_MANIFEST << " " << EXTERNAL_SFC_MANIFEST_VERSION << "\n";
+	out << "level " << level << "\ntype " << (uint)type << "\n";
+	out << "frame " << frame.origin.x << " " << frame.origin.y << " " << frame.radius << "\n";
+	out << "covered " << coveredNum << "\ninput_done " << (inputDone ? 1 : 0) << "\n";
+	out << "next_run " << nextRun << "\nspilled " << spilledRunNum << "\nmerge_passes " << mergePassNum << "\n";
+	out << "runs " << runs.size() << "\n";
+	for (size_t r = 0; r < runs.size(); r++) {
+		out << runs[r].substr(workDir.size() + 1) << " " << runSizes[r] << "\n";
+	}
+
+	if (!WriteDurableFile(ManifestPath(), out.str())) {
+		cout << "File " << ManifestPath() << " cannot be written." << endl;
+		return false;
+	}
+	return true;
+}
+
+bool ExternalSFCBuilder::LoadManifest()
+{
+	Reset();
+	ifstream f(ManifestPath().c_str());
+	if (!f.is_open())
+		return true;
+
+	string magic, key[9];
+	uint version = 0, fileLevel = 0, fileType = 0, done = 0;
+	Frame fileFrame;
+	size_t runNum = 0;
+	f >> magic >> version >> key[0] >> fileLevel >> key[1] >> fileType >> key[2] >> fileFrame.origin.x >> fileFrame.origin.y >> fileFrame.radius >>
+		key[3] >> coveredNum >> key[4] >> done >> key[5] >> nextRun >> key[6] >> spilledRunNum >> key[7] >> mergePassNum >> key[8] >> runNum;
+	bool ok = f && magic == EXTERNAL_SFC_MANIFEST && version == EXTERNAL_SFC_MANIFEST_VERSION && key[8] == "runs" &&
+		fileLevel == level && fileType == (uint)type && fileFrame.origin.x == frame.origin.x &&
+		fileFrame.origin.y == frame.origin.y && fileFrame.radius == frame.radius;
+
+	//Runs have to be complete
+	unsigned long long total = 0;
+	for (size_t r = 0; ok && r < runNum; r++) {
+		string name;
+		unsigned long long size;
+		ok = (f >> name >> size) && name.find_first_of("/\\") == string::npos;
+		if (ok) {
+			runs.push_back(workDir + "/" + name);
+			runSizes.push_back(size);
+			total += size;
+			ifstream run(runs.back().c_str(), ios::binary | ios::ate);
+			ok = run.is_open() && (unsigned long long)run.tellg() == size * sizeof(StreamRecord);
+		}
+	}
+	inputDone = (done != 0);
+	pointNum = (inputDone ? coveredNum : 0);
+	ok = ok && total == coveredNum;
+
+	if (!ok) {
+		Reset();
+		cout << "Error while reading file " << ManifestPath() << "." << endl;
+	}
+	return ok;
+}
+
+bool ExternalSFCBuilder::Build(int fd, string outputPath)
+{
+	//A checkpoint of another build is not valid any more
+	Reset();
+	remove(ManifestPath().c_str());
+	return Construct(fd, outputPath);
+}
+
+bool ExternalSFCBuilder::Resume(int fd, string outputPath)
+{
+	return LoadManifest() && Construct(fd, outputPath);
+}
+
+bool ExternalSFCBuilder::SpillInput(int fd)
+{
+	//Two buffers of records in the rest of the budget left by the encoder, padded for direct I/O
+	const uint blockSize = 1 << 15;
+	const uint depth = 4;
+	const size_t inputSize = 1 << 20;
+	const size_t capacity = (memoryBudget - inputSize - (size_t)depth * blockSize * sizeof(StreamRecord) - 2 * DIRECT_IO_ALIGNMENT) / sizeof(StreamRecord) / 2;
+	StreamRecord * buffers[2];
+	for (int b = 0; b < 2; b++) {
+		buffers[b] = (StreamRecord *)AllocAligned(capacity * sizeof(StreamRecord) + DIRECT_IO_ALIGNMENT);
+	}
+	if (!buffers[0] || !buffers[1]) {
+		FreeAligned((char *)buffers[0]);
+		FreeAligned((char *)buffers[1]);
+		cout << "ERROR: Memory budget cannot be allocated" << endl;
+		return false;
+	}
+
+	//Full buffer spilled in the background, the previous spill has to be finished
+	//(runs cover consecutive points of the input, so no run is spilled behind a failed one)
+	bool spillOk = true;
+	thread spiller;
+	auto spill = [&](StreamRecord * records, size_t num) {
+		if (spiller.joinable())
+			spiller.join();
+		spiller = thread([&, records, num]() {
+			spillOk = spillOk && SpillRun(records, num);
+		});
+	};
+
+	//Points of the runs of a resumed build are skipped
+	StreamRecord * records = buffers[0];
+	size_t num = 0;
+	StreamEncoder encoder(level, type, frame, blockSize, inputSize, threads, depth);
+	bool ok = encoder.Encode(fd, [&](const StreamRecord * r, uint n) {
+		for (uint i = 0; i < n; i++) {
+			if (num == capacity) {
+				spill(records, num);
+				records = (records == buffers[0] ? buffers[1] : buffers[0]);
+				num = 0;
+			}
+			records[num++] = r[i];
+		}
+	}, coveredNum);
+	if (num > 0)
+		spill(records, num);
+	if (spiller.joinable())
+		spiller.join();
+	ok = ok && spillOk;
+	FreeAligned((char *)buffers[0]);
+	FreeAligned((char *)buffers[1]);
+	pointNum = encoder.GetPointNum();
+
+	//The input of a resumed build cannot be shorter
+	ok = ok && pointNum == coveredNum;
+	if (ok) {
+		inputDone = true;
+		ok = SaveManifest();
+	}
+	return ok;
+}
+
+bool ExternalSFCBuilder::Construct(int fd, string outputPath)
+{
+	bool ok = (inputDone || SpillInput(fd));
+
+	//Groups of runs merged until all runs fit into the budget, the merged runs are removed behind the checkpoint
+	const size_t fanIn = (memoryBudget / MIN_MERGE_BUFFER > 3 ? memoryBudget / MIN_MERGE_BUFFER - 1 : 2);
+	while (ok && runs.size() > fanIn) {
+		vector<string> group(runs.begin(), runs.begin() + fanIn);
+		unsigned long long size = 0;
+		for (size_t r = 0; r < fanIn; r++) {
+			size += runSizes[r];
+		}
+		string merged = RunPath(nextRun++);
+		ok = MergeRuns(group, merged, false);
+		if (ok) {
+			runs.erase(runs.begin(), runs.begin() + fanIn);
+			runSizes.erase(runSizes.begin(), runSizes.begin() + fanIn);
+			runs.push_back(merged);
+			runSizes.push_back(size);
+			mergePassNum++;
+			ok = SaveManifest();
+		}
+		if (ok)
+			RemoveRuns(group);
+	}
+	if (ok) {
+		ok = MergeRuns(runs, outputPath, true);
+		mergePassNum++;
+	}
+
+	//Runs of a failed build are kept for Resume
+	if (ok) {
+		RemoveRuns(runs);
+		runs.clear();
+		runSizes.clear();
+		remove(ManifestPath().c_str());
+	}
+	else
+		cout << "Error while building file " << outputPath << "." << endl;
+	return ok;
+}
+
+int ExternalSFCBuilder::OpenInput(string path)
+{
+#ifdef _WIN32
+	int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+#endif
+	if (fd < 0)
+		cout << "File " << path << " cannot be opened." << endl;
+	return fd;
+}
+
+bool ExternalSFCBuilder::Build(string inputPath, string outputPath)
+{
+	int fd = OpenInput(inputPath);
+	if (fd < 0)
+		return false;
+
+	bool ok = Build(fd, outputPath);
+#ifdef _WIN32
+	_close(fd);
+#else
+	close(fd);
+#endif
+	return ok;
+}
+
+bool ExternalSFCBuilder::Resume(string inputPath, string outputPath)
+{
+	if (!LoadManifest())
+		return false;
+	if (inputDone)
+		return Construct(-1, outputPath);
+
+	int fd = OpenInput(inputPath);
+	if (fd < 0)
+		return false;
+
+	bool ok = Construct(fd, outputPath);
+#ifdef _WIN32
+	_close(fd);
+#else
+	close(fd);
+#endif
+	return ok;
+}
+
+bool ExternalSFCBuilder::SpillRun(StreamRecord * records, size_t num)
+{
+	sort(records, records + num, RecordLess);
+
+	//Whole aligned blocks are written and flushed to the disk before the checkpoint, the padding is cut
+	string path = RunPath(nextRun++);
+	DirectFile file;
+	size_t size = num * sizeof(StreamRecord);
+	size_t padded = (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+	bool ok = file.Open(path, true) && file.Write((const char *)records, padded) && file.Truncate(size) && file.Sync();
+	file.Close();
+	if (!ok) {
+		cout << "File " << path << " cannot be written." << endl;
+		return false;
+	}
+
+	runs.push_back(path);
+	runSizes.push_back(num);
+	coveredNum += num;
+	spilledRunNum++;
+	return SaveManifest();
+}
+
+bool ExternalSFCBuilder::MergeRuns(const vector<string> & inputs, string outputPath, bool final)
+{
+	//Budget split among buffers of inputs and of the output
+	const uint k = (uint)inputs.size();
+	size_t bufferSize = memoryBudget / (k + 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+	bufferSize = (bufferSize > (64 << 20) ? (64 << 20) : bufferSize);
+
+	vector<RunReader> readers(k);
+	bool ok = true;
+	for (uint r = 0; r < k && ok; r++) {
+		ok = readers[r].Open(inputs[r], bufferSize);
+	}
+
+	RunWriter writer;
+	ok = ok && writer.Open(outputPath, bufferSize, final ? RECORD_FILE_DATA_OFFSET : 0);
+	if (!ok)
+		return false;
+
+	RecordFileHeader header;
+	header.type = type;
+	header.level = level;
+	header.origin[0] = frame.origin.x;
+	header.origin[1] = frame.origin.y;
+	header.radius = frame.radius;
+	for (uint d = 0; d < 2; d++) {
+		header.bbMin[d] = numeric_limits<double>::max();
+		header.bbMax[d] = -numeric_limits<double>::max();
+	}
+
+	if (k > 0) {
+		auto less = [&](uint a, uint b) {
+			const StreamRecord * ra = readers[a].Head(), * rb = readers[b].Head();
+			return ra && (!rb || RecordLess(*ra, *rb));
+		};
+		LoserTree<decltype(less)> tree(k, less);
+		for (const StreamRecord * r; (r = readers[tree.Winner()].Head()) != NULL;) {
+			writer.Append(*r);
+			for (uint d = 0; d < 2; d++) {
+				header.bbMin[d] = (r->point.arr[d] < header.bbMin[d] ? r->point.arr[d] : header.bbMin[d]);
+				header.bbMax[d] = (r->point.arr[d] > header.bbMax[d] ? r->point.arr[d] : header.bbMax[d]);
+			}
+			readers[tree.Winner()].Advance();
+			tree.Replay();
+		}
+	}
+	for (uint r = 0; r < k; r++) {
+		ok = ok && !readers[r].Failed();
+	}
+
+	header.count = writer.GetCount();
+	if (header.count == 0) {
+		for (uint d = 0; d < 2; d++) {
+			header.bbMin[d] = header.bbMax[d] = 0.;
+		}
+	}
+	return writer.Finish(final ? &header : NULL, sizeof(RecordFileHeader)) && ok;
+}
+
+void ExternalSFCBuilder::RemoveRuns(const vector<string> & paths)
+{
+	for (size_t r = 0; r < paths.size(); r++) {
+		remove(paths[r].c_str());
+	}
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+
+#include <vector>
+#include <atomic>
+#include "Inflate.h"
+#include "Parallel.h"
+
+/*
+Gzip file (RFC 1952)
+
+A file is a sequence of members, each member is a header, a DEFLATE stream and a trailer (CRC-32 and size \
+of the data). Members of BGZF files (e.g. produced by bgzip) store their size in the extra field "BC", \
+so they can be found without decoding and decompressed in parallel.
+*/
+
+#define GZIP_FLAG_HCRC 2 //Header CRC present
+#define GZIP_FLAG_EXTRA 4 //Extra field present
+#define GZIP_FLAG_NAME 8 //File name present
+#define GZIP_FLAG_COMMENT 16 //Comment present
+#define GZIP_TRAILER_SIZE 8 //CRC-32 and size of the data
+
+//Member of a gzip file
+struct GzipMember
+{
+	size_t offset; //Offset of the member in the file
+	size_t dataOffset; //Offset of the DEFLATE stream
+	size_t size; //Size of the whole member given by the BGZF extra field (0 = unknown)
+
+	/*
+	Reads header of the member at offset, returns false if there is no valid header
+	*/
+	bool Read(const char * data, size_t fileSize, size_t _offset) {
+		const unsigned char * p = (const unsigned char *)data;
+		offset = _offset;
+		size = 0;
+		if (fileSize < offset + 10 || p[offset] != 0x1f || p[offset + 1] != 0x8b || p[offset + 2] != 8)
+			return false;
+		const uint flags = p[offset + 3];
+		size_t pos = offset + 10;
+
+		if (flags & GZIP_FLAG_EXTRA) {
+			if (fileSize < pos + 2)
+				return false;
+			const size_t extraSize = p[pos] | (p[pos + 1] << 8);
+			pos += 2;
+			if (fileSize < pos + extraSize)
+				return false;
+			//Subfields: two identifier bytes, length, data
+			for (size_t s = pos; s + 4 <= pos + extraSize;) {
+				const size_t len = p[s + 2] | (p[s + 3] << 8);
+				if (p[s] == 'B' && p[s + 1] == 'C' && len == 2 && s + 6 <= pos + extraSize)
+					size = (size_t)(p[s + 4] | (p[s + 5] << 8)) + 1;
+				s += 4 + len;
+			}
+			pos += extraSize;
+		}
+		for (uint f = GZIP_FLAG_NAME; f <= GZIP_FLAG_COMMENT; f <<= 1) {
+			if (flags & f) {
+				while (pos < fileSize && p[pos] != 0)
+					pos++;
+				pos++;
+			}
+		}
+		if (flags & GZIP_FLAG_HCRC)
+			pos += 2;
+
+		dataOffset = pos;
+		if (size > 0 && (size < dataOffset - offset + GZIP_TRAILER_SIZE || fileSize - offset < size))
+			return false;
+		return pos + GZIP_TRAILER_SIZE <= fileSize;
+	}
+};
+
+/*
+Decompressor of a gzip file in memory (e.g. a mapped file)
+
+BGZF members are decompressed in parallel batches, other members sequentially in parts, \
+the data are passed to the caller in order.
+*/
+class GzipReader
+{
+private:
+	const char * data; //Compressed file
+	size_t size; //Size of the file
+	uint threads; //Number of threads decompressing BGZF members
+
+	/*
+	Returns CRC-32 and size from the trailer at offset
+	*/
+	void ReadTrailer(size_t offset, uint & crc, uint & dataSize) {
+		memcpy(&crc, data + offset, 4);
+		memcpy(&dataSize, data + offset + 4, 4);
+	}
+	/*
+	Decompresses a member of known size (BGZF) at once, returns false on error
+	*/
+	bool InflateMember(const GzipMember & m, vector<char> & out);
+	/*
+	Decompresses a member in parts of about partSize bytes passed to emit, sets end to the end of the member, \
+	returns false on error
+	*/
+	template <class F> bool StreamMember(const GzipMember & m, F & emit, size_t partSize, size_t & end);
+
+public:
+	/*
+	_threads - number of threads decompressing BGZF members (0 = all hardware threads)
+	*/
+	GzipReader(const char * _data, size_t _size, uint _threads = 0) : data(_data), size(_size), threads(_threads) {}
+
+	/*
+	Returns true if the data begin by the gzip magic bytes
+	*/
+	static bool IsGzip(const char * data, size_t size) {
+		return size >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b;
+	}
+	/*
+	Decompresses all members, the data are passed in order by emit(const char * data, size_t size), \
+	which returns false to stop. Returns false on an invalid file or if stopped.
+
+	partSize - approximate size of the data decompressed between calls of emit
+	*/
+	template <class F> bool Decompress(F emit, size_t partSize = 1 << 22);
+};
+
+inline bool GzipReader::InflateMember(const GzipMember & m, vector<char> & out)
+{
+	const size_t trailer = m.offset + m.size - GZIP_TRAILER_SIZE;
+	uint crc, dataSize;
+	ReadTrailer(trailer, crc, dataSize);
+
+	out.clear();
+	out.reserve(dataSize);
+	Inflater inflater(data + m.dataOffset, trailer - m.dataOffset);
+	return inflater.Inflate(out, (size_t)-1) && inflater.IsFinished() && inflater.GetConsumed() <= trailer - m.dataOffset &&
+		(uint)out.size() == dataSize && (out.empty() || Crc32::Update(0, &out[0], out.size()) == crc);
+}
+
+template <class F> bool GzipReader::StreamMember(const GzipMember & m, F & emit, size_t partSize, size_t & end)
+{
+	Inflater inflater(data + m.dataOffset, size - m.dataOffset);
+	vector<char> buffer;
+	size_t kept = 0; //Bytes of the previous parts kept for back-references
+	uint crc = 0;
+	uint dataSize = 0;
+
+	while (!inflater.IsFinished()) {
+		if (!inflater.Inflate(buffer, partSize))
+			return false;
+		const size_t n = buffer.size() - kept;
+		if (n > 0) {
+			crc = Crc32::Update(crc, &buffer[kept], n);
+			dataSize += (uint)n;
+			if (!emit((const char *)&buffer[kept], n))
+				return false;
+		}
+		kept = (buffer.size() < INFLATE_WINDOW ? buffer.size() : INFLATE_WINDOW);
+		buffer.erase(buffer.begin(), buffer.end() - kept);
+	}
+
+	const size_t trailer = m.dataOffset + inflater.GetConsumed();
+	if (trailer + GZIP_TRAILER_SIZE > size)
+		return false;
+	uint storedCrc, storedSize;
+	ReadTrailer(trailer, storedCrc, storedSize);
+	end = trailer + GZIP_TRAILER_SIZE;
+	return storedCrc == crc && storedSize == dataSize;
+}
+
+template <class F> bool GzipReader::Decompress(F emit, const size_t partSize)
+{
+	const uint batchSize = 64 * ThreadNum(threads);
+	vector<GzipMember> batch;
+	vector<vector<char> > parts;
+
+	size_t offset = 0;
+	while (offset < size) {
+		GzipMember m;
+		if (!m.Read(data, size, offset))
+			return false;
+
+		if (m.size == 0) {
+			if (!StreamMember(m, emit, partSize, offset))
+				return false;
+			continue;
+		}
+
+		//Batch of consecutive BGZF members decompressed in parallel
+		batch.assign(1, m);
+		offset += m.size;
+		while (batch.size() < batchSize && offset < size && m.Read(data, size, offset) && m.size > 0) {
+			batch.push_back(m);
+			offset += m.size;
+		}
+		parts.resize(batch.size());
+		atomic<bool> ok(true);
+		ParallelFor((uint)batch.size(), [&](uint j) {
+			if (!InflateMember(batch[j], parts[j]))
+				ok = false;
+		}, threads);
+		if (!ok)
+			return false;
+		for (size_t j = 0; j < batch.size(); j++) {
+			if (!parts[j].empty() && !emit((const char *)&parts[j][0], parts[j].size()))
+				return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstring>
+#include "common.h"
+
+/*
+Binary file of a constructed SFC index
+
+The header is followed by sections at the given offsets (aligned to 64 bytes):
+codes - sorted codes (count x 8 bytes), or compressed codes of codesSize bytes \
+	if INDEX_FILE_COMPRESSED_CODES flag is set (see CompressedCodes.h)
+indices - point indices along SFC (count x 4 bytes)
+points - points in the original order (count x dimension x 8 bytes)
+*/
+
+#define INDEX_FILE_MAGIC "NGSI"
+#define INDEX_FILE_VERSION 2
+#define INDEX_FILE_COMPRESSED_CODES 1 //Flag of the compressed section of codes
+#define INDEX_FILE_ALIGNMENT 64
+
+//Header of the index file (256 bytes)
+struct IndexFileHeader
+{
+	char magic[4]; //INDEX_FILE_MAGIC
+	uint version; //INDEX_FILE_VERSION
+	uint dimension; //Dimension of points
+	uint type; //Type of indexation pattern
+	uint level; //Index of max. level of recursion
+	uint flags; //Flags of optional sections (version 1 has no flags)
+	unsigned long long count; //Number of points
+	double smallHexSize; //Size of hexagons of the deepest level of recursion
+	double origin[3]; //Center of the root Gosper island
+	double bbMin[3]; //BB of the point cloud
+	double bbMax[3];
+	double center[3]; //Translation subtracted from the points
+	unsigned long long codesOffset; //Offsets of sections from the beginning of the file
+	unsigned long long indicesOffset;
+	unsigned long long pointsOffset;
+	unsigned long long codesSize; //Size of the compressed section of codes in bytes (since version 2)
+	char padding[88];
+
+	IndexFileHeader() {
+		memset(this, 0, sizeof(IndexFileHeader));
+		memcpy(magic, INDEX_FILE_MAGIC, 4);
+		version = INDEX_FILE_VERSION;
+	}
+	/*
+	Computes aligned offsets of sections, returns size of the file
+	*/
+	unsigned long long Layout() {
+		codesOffset = Align(sizeof(IndexFileHeader));
+		indicesOffset = Align(codesOffset + ((flags & INDEX_FILE_COMPRESSED_CODES) ? codesSize : count * sizeof(CODE)));
+		pointsOffset = Align(indicesOffset + count * sizeof(uint));
+		return pointsOffset + count * dimension * sizeof(REAL);
+	}
+	/*
+	Returns true if the header is valid
+	*/
+	bool IsValid(unsigned long long fileSize) const {
+		IndexFileHeader h = *this;
+		return memcmp(magic, INDEX_FILE_MAGIC, 4) == 0 && version >= 1 && version <= INDEX_FILE_VERSION &&
+			(version > 1 || flags == 0) && (flags & ~INDEX_FILE_COMPRESSED_CODES) == 0 && codesSize <= fileSize && dimension > 0 && dimension <= 3 &&
+			count <= 0xFFFFFFFFULL && h.Layout() <= fileSize && h.codesOffset == codesOffset &&
+			h.indicesOffset == indicesOffset && h.pointsOffset == pointsOffset;
+	}
+	/*
+	Returns offset aligned to INDEX_FILE_ALIGNMENT
+	*/
+	static unsigned long long Align(unsigned long long offset) {
+		return (offset + INDEX_FILE_ALIGNMENT - 1) / INDEX_FILE_ALIGNMENT * INDEX_FILE_ALIGNMENT;
+	}
+};
+
+static_assert(sizeof(IndexFileHeader) == 256, "Unexpected size of IndexFileHeader");
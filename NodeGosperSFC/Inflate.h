@@ -0,0 +1,453 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+
+#include <cstring>
+#include <vector>
+#include "common.h"
+#include "BitPacking.h"
+
+using namespace std;
+
+#define INFLATE_WINDOW 32768 //Max. distance of back-references
+#define INFLATE_FAST_BITS 10 //Codes of up to this length are decoded by one table lookup
+
+/*
+CRC-32 of gzip (polynomial 0xEDB88320) computed by slicing-by-8
+*/
+class Crc32
+{
+private:
+	/*
+	Returns 8 tables of 256 entries
+	*/
+	static const uint * Tables() {
+		static const struct CrcTables {
+			uint t[8][256];
+			CrcTables() {
+				for (uint n = 0; n < 256; n++) {
+					uint c = n;
+					for (int k = 0; k < 8; k++)
+						c = (c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1);
+					t[0][n] = c;
+				}
+				for (uint n = 0; n < 256; n++) {
+					for (int k = 1; k < 8; k++)
+						t[k][n] = (t[k - 1][n] >> 8) ^ t[0][t[k - 1][n] & 0xFF];
+				}
+			}
+		} tables;
+		return &tables.t[0][0];
+	}
+
+public:
+	/*
+	Returns CRC of the data following the data of CRC crc (0 for the beginning)
+	*/
+	static uint Update(uint crc, const char * data, size_t size) {
+		const uint * t = Tables();
+		const unsigned char * p = (const unsigned char *)data;
+		crc = ~crc;
+		for (; size >= 8; size -= 8, p += 8) {
+			uint a, b;
+			memcpy(&a, p, 4);
+			memcpy(&b, p + 4, 4);
+			a ^= crc;
+			crc = t[7 * 256 + (a & 0xFF)] ^ t[6 * 256 + ((a >> 8) & 0xFF)] ^ t[5 * 256 + ((a >> 16) & 0xFF)] ^ t[4 * 256 + (a >> 24)] ^
+				t[3 * 256 + (b & 0xFF)] ^ t[2 * 256 + ((b >> 8) & 0xFF)] ^ t[1 * 256 + ((b >> 16) & 0xFF)] ^ t[b >> 24];
+		}
+		for (; size > 0; size--, p++)
+			crc = t[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+};
+
+/*
+Canonical Huffman code of DEFLATE
+
+Short codes are decoded by a table indexed by the next INFLATE_FAST_BITS bits, \
+longer codes by limits of left-aligned codes of each length.
+*/
+struct HuffmanTable
+{
+	unsigned short fast[1 << INFLATE_FAST_BITS]; //(length << 9) | symbol of short codes, 0 for longer codes
+	unsigned short firstCode[16]; //First code of each length
+	unsigned short firstSymbol[16]; //Index of the first symbol of each length in the sorted symbols
+	uint maxCode[17]; //Limit of left-aligned 16-bit codes of each length
+	unsigned char size[288]; //Code lengths of the sorted symbols
+	unsigned short value[288]; //Sorted symbols
+
+	/*
+	Builds the code from code lengths of num symbols, returns false for an oversubscribed code
+	*/
+	bool Build(const unsigned char * lengths, uint num) {
+		uint counts[16] = { 0 };
+		uint nextCode[16];
+		memset(fast, 0, sizeof(fast));
+		memset(size, 0, sizeof(size));
+		for (uint i = 0; i < num; i++)
+			counts[lengths[i]]++;
+		counts[0] = 0;
+
+		uint code = 0, k = 0;
+		for (uint s = 1; s < 16; s++) {
+			nextCode[s] = code;
+			firstCode[s] = (unsigned short)code;
+			firstSymbol[s] = (unsigned short)k;
+			code += counts[s];
+			if (counts[s] > 0 && code - 1 >= (1u << s))
+				return false;
+			maxCode[s] = code << (16 - s);
+			code <<= 1;
+			k += counts[s];
+		}
+		maxCode[16] = 0x10000;
+
+		for (uint i = 0; i < num; i++) {
+			const uint s = lengths[i];
+			if (s == 0)
+				continue;
+			const uint c = nextCode[s] - firstCode[s] + firstSymbol[s];
+			size[c] = (unsigned char)s;
+			value[c] = (unsigned short)i;
+			if (s <= INFLATE_FAST_BITS) {
+				for (uint j = Reverse(nextCode[s], s); j < (1u << INFLATE_FAST_BITS); j += (1u << s))
+					fast[j] = (unsigned short)((s << 9) | i);
+			}
+			nextCode[s]++;
+		}
+		return true;
+	}
+	/*
+	Returns the lowest bits of v in the reversed order
+	*/
+	static inline uint Reverse(uint v, uint bits) {
+		v = ((v & 0xAAAA) >> 1) | ((v & 0x5555) << 1);
+		v = ((v & 0xCCCC) >> 2) | ((v & 0x3333) << 2);
+		v = ((v & 0xF0F0) >> 4) | ((v & 0x0F0F) << 4);
+		v = ((v & 0xFF00) >> 8) | ((v & 0x00FF) << 8);
+		return v >> (16 - bits);
+	}
+};
+
+/*
+Decoder of a DEFLATE stream (RFC 1951)
+
+The output is decoded by whole blocks, so a long stream can be decoded in parts \
+keeping the last INFLATE_WINDOW bytes of the output for back-references.
+*/
+class Inflater
+{
+private:
+	const unsigned char * begin, * in, * end; //Input
+	WORD64 bitBuffer; //Bits read ahead (the lowest bit is the next one)
+	uint bitNum; //Number of bits in the buffer
+	uint padding; //Number of zero bytes read behind the end of the input
+	bool final; //The last block was decoded
+	bool failed; //Invalid stream
+	HuffmanTable litLen, dist; //Codes of the current block
+	vector<char> * output; //Output of the current call (enlarged ahead)
+	size_t pos; //Number of output bytes
+
+	/*
+	Enlarges the output to hold n more bytes, returns the output
+	*/
+	inline char * Reserve(size_t n) {
+		if (pos + n > output->size())
+			output->resize(2 * (pos + n));
+		return &(*output)[0];
+	}
+
+	/*
+	Fills the bit buffer to at least 57 bits
+	*/
+	inline void Refill() {
+		if (end - in >= 8) {
+			//Whole bytes fitting into the buffer loaded at once
+			WORD64 v;
+			memcpy(&v, in, 8);
+			bitBuffer |= v << bitNum;
+			in += (63 - bitNum) >> 3;
+			bitNum |= 56;
+			return;
+		}
+		while (bitNum <= 56) {
+			if (in < end)
+				bitBuffer |= (WORD64)*in++ << bitNum;
+			else
+				padding++;
+			bitNum += 8;
+		}
+	}
+	/*
+	Reads bits (at most 32, the buffer has to be filled)
+	*/
+	inline uint Bits(uint n) {
+		const uint v = (uint)(bitBuffer & ((((WORD64)1) << n) - 1));
+		bitBuffer >>= n;
+		bitNum -= n;
+		return v;
+	}
+	/*
+	Decodes a symbol, returns -1 for an invalid code (the buffer has to be filled)
+	*/
+	inline int Decode(const HuffmanTable & h) {
+		uint b = h.fast[bitBuffer & ((1 << INFLATE_FAST_BITS) - 1)];
+		if (b) {
+			Bits(b >> 9);
+			return (int)(b & 511);
+		}
+		const uint k = HuffmanTable::Reverse((uint)(bitBuffer & 0xFFFF), 16);
+		uint s = INFLATE_FAST_BITS + 1;
+		while (s < 16 && k >= h.maxCode[s])
+			s++;
+		if (s >= 16)
+			return -1;
+		b = (k >> (16 - s)) - h.firstCode[s] + h.firstSymbol[s];
+		if (b >= 288 || h.size[b] != s)
+			return -1;
+		Bits(s);
+		return h.value[b];
+	}
+	/*
+	Reads code lengths of a dynamic block and builds its codes
+	*/
+	bool ReadDynamicCodes();
+	/*
+	Decodes symbols of a compressed block
+	*/
+	bool DecodeSymbols();
+	/*
+	Copies a stored block
+	*/
+	bool CopyStored();
+
+public:
+	/*
+	data - DEFLATE stream (the stream may be followed by other data)
+	*/
+	Inflater(const char * data, size_t size) : begin((const unsigned char *)data), in(begin), end(begin + size),
+		bitBuffer(0), bitNum(0), padding(0), final(false), failed(false), output(NULL), pos(0) {}
+
+	/*
+	Decodes whole blocks appended to out until at least minOut bytes are appended or the last block \
+	is decoded, returns false for an invalid or truncated stream. \
+	Back-references may point into the previous content of out.
+	*/
+	bool Inflate(vector<char> & out, size_t minOut);
+	/*
+	Returns true if the last block was decoded
+	*/
+	bool IsFinished() { return final; }
+	/*
+	Returns number of input bytes of the stream (valid after the last block)
+	*/
+	size_t GetConsumed() {
+		return (size_t)(in - begin) + padding - bitNum / 8;
+	}
+};
+
+inline bool Inflater::Inflate(vector<char> & out, size_t minOut)
+{
+	const size_t start = out.size();
+	output = &out;
+	pos = start;
+	Reserve(minOut < (1 << 24) ? minOut : (1 << 16));
+	while (!final && !failed && pos - start < minOut) {
+		Refill();
+		final = (Bits(1) == 1);
+		const uint type = Bits(2);
+		if (type == 0) {
+			failed = !CopyStored();
+		}
+		else if (type == 1) {
+			//Fixed codes
+			unsigned char lengths[288];
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			litLen.Build(lengths, 288);
+			memset(lengths, 5, 32);
+			dist.Build(lengths, 32);
+			failed = !DecodeSymbols();
+		}
+		else if (type == 2) {
+			failed = !ReadDynamicCodes() || !DecodeSymbols();
+		}
+		else {
+			failed = true;
+		}
+		//Bits read behind the end of the input
+		failed |= (padding * 8 > bitNum);
+	}
+	out.resize(pos);
+	output = NULL;
+	return !failed;
+}
+
+inline bool Inflater::CopyStored()
+{
+	//Length follows at the byte boundary
+	Bits(bitNum % 8);
+	const uint len = Bits(16);
+	const uint nlen = Bits(16);
+	if ((len ^ 0xFFFF) != nlen)
+		return false;
+
+	char * o = Reserve(len);
+	uint n = 0;
+	for (; n < len && bitNum >= 8 + padding * 8; n++)
+		o[pos++] = (char)Bits(8);
+	if (n < len) {
+		//The bit buffer is empty (except of padding and bytes read ahead) here
+		if ((size_t)(end - in) < len - n || padding > 0)
+			return false;
+		bitBuffer = 0;
+		memcpy(o + pos, in, len - n);
+		in += len - n;
+		pos += len - n;
+	}
+	return true;
+}
+
+inline bool Inflater::ReadDynamicCodes()
+{
+	static const unsigned char order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	const uint hlit = Bits(5) + 257;
+	const uint hdist = Bits(5) + 1;
+	const uint hclen = Bits(4) + 4;
+	if (hlit > 286 || hdist > 30)
+		return false;
+
+	unsigned char lengths[286 + 30 + 1];
+	memset(lengths, 0, 19);
+	for (uint i = 0; i < hclen; i++) {
+		Refill();
+		lengths[order[i]] = (unsigned char)Bits(3);
+	}
+	HuffmanTable lengthCode;
+	if (!lengthCode.Build(lengths, 19))
+		return false;
+
+	uint n = 0;
+	while (n < hlit + hdist) {
+		Refill();
+		const int c = Decode(lengthCode);
+		if (c < 0)
+			return false;
+		if (c < 16) {
+			lengths[n++] = (unsigned char)c;
+			continue;
+		}
+		uint repeat;
+		unsigned char fill = 0;
+		if (c == 16) {
+			if (n == 0)
+				return false;
+			fill = lengths[n - 1];
+			repeat = 3 + Bits(2);
+		}
+		else if (c == 17) {
+			repeat = 3 + Bits(3);
+		}
+		else {
+			repeat = 11 + Bits(7);
+		}
+		if (n + repeat > hlit + hdist)
+			return false;
+		memset(lengths + n, fill, repeat);
+		n += repeat;
+	}
+	if (lengths[256] == 0)
+		return false;
+
+	return litLen.Build(lengths, hlit) && dist.Build(lengths + hlit, hdist);
+}
+
+inline bool Inflater::DecodeSymbols()
+{
+	static const unsigned short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const unsigned char lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const unsigned short distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const unsigned char distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	//Output written through a pointer, the vector is enlarged ahead
+	char * o = Reserve(258);
+	size_t capacity = output->size();
+
+	for (;;) {
+		Refill();
+		if (padding * 8 > bitNum)
+			return false;
+		if (pos + 258 > capacity) {
+			o = Reserve(258);
+			capacity = output->size();
+		}
+
+		int sym = Decode(litLen);
+		if (sym < 256) {
+			if (sym < 0)
+				break;
+			o[pos++] = (char)sym;
+			continue;
+		}
+		if (sym == 256)
+			return true;
+
+		sym -= 257;
+		if (sym >= 29)
+			break;
+		const uint len = lengthBase[sym] + Bits(lengthExtra[sym]);
+		const int d = Decode(dist);
+		if (d < 0 || d >= 30)
+			break;
+		const size_t distance = distBase[d] + Bits(distExtra[d]);
+		if (distance > pos)
+			break;
+
+		char * dst = o + pos;
+		const char * src = dst - distance;
+		if (distance >= len) {
+			memcpy(dst, src, len);
+		}
+		else {
+			for (uint i = 0; i < len; i++)
+				dst[i] = src[i];
+		}
+		pos += len;
+	}
+
+	return false;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstring>
+#include "common.h"
+
+/*
+Header of a binary LAS file (versions 1.0 - 1.4, uncompressed point data record formats 0 - 10)
+
+Records of points start at pointOffset and have recordLength bytes, each begins with coordinates \
+X, Y, Z stored as 32-bit integers, the real coordinates are X * scale + offset.
+*/
+
+#define LAS_FILE_MAGIC "LASF"
+#define LAS_MAX_FORMAT 10
+
+//Min. length of point data records of formats 0 - 10
+const uint lasRecordLength[LAS_MAX_FORMAT + 1] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+
+struct LasHeader
+{
+	uint versionMajor, versionMinor; //Version of the format
+	uint headerSize; //Size of the public header block
+	unsigned long long pointOffset; //Offset of point data records from the beginning of the file
+	uint format; //Point data record format
+	uint recordLength; //Size of a point data record (including extra bytes)
+	unsigned long long count; //Number of points
+	double scale[3]; //Scale factors of coordinates
+	double offset[3]; //Offsets of coordinates
+	double min[3], max[3]; //BB of points stored in the header
+
+	/*
+	Reads the header from the beginning of a file, returns false if the file is not \
+	a valid uncompressed LAS file
+	*/
+	bool Read(const char * data, size_t size) {
+		if (size < 227 || memcmp(data, LAS_FILE_MAGIC, 4) != 0)
+			return false;
+
+		versionMajor = (unsigned char)data[24];
+		versionMinor = (unsigned char)data[25];
+		headerSize = Get<unsigned short>(data, 94);
+		pointOffset = Get<uint>(data, 96);
+		format = (unsigned char)data[104];
+		recordLength = Get<unsigned short>(data, 105);
+		count = Get<uint>(data, 107);
+		for (uint d = 0; d < 3; d++) {
+			scale[d] = Get<double>(data, 131 + 8 * d);
+			offset[d] = Get<double>(data, 155 + 8 * d);
+			max[d] = Get<double>(data, 179 + 16 * d);
+			min[d] = Get<double>(data, 187 + 16 * d);
+		}
+
+		//64-bit number of points since version 1.4
+		if (versionMajor == 1 && versionMinor >= 4 && headerSize >= 375 && size >= 375) {
+			unsigned long long count64 = Get<unsigned long long>(data, 247);
+			count = (count == 0 ? count64 : count);
+		}
+
+		//Compressed formats (LAZ) set the high bits of the format
+		return versionMajor == 1 && format <= LAS_MAX_FORMAT && recordLength >= lasRecordLength[format] &&
+			headerSize <= pointOffset && pointOffset <= size && count <= (size - pointOffset) / recordLength;
+	}
+	/*
+	Returns value of type T at offset of the buffer
+	*/
+	template <class T> static T Get(const char * data, size_t offset) {
+		T v;
+		memcpy(&v, data + offset, sizeof(T));
+		return v;
+	}
+};
@@ -0,0 +1,438 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <glob.h>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+/*
+Returns name of a shared memory segment in the form required by the platform (POSIX names start by a slash)
+*/
+inline string SharedMemoryName(string name)
+{
+#ifdef _WIN32
+	return name;
+#else
+	return (!name.empty() && name[0] == '/' ? name : "/" + name);
+#endif
+}
+
+/*
+Read-only or copy-on-write memory mapping of a file or of a named shared memory segment
+*/
+class MappedFile
+{
+private:
+	const char * data; //Mapped memory
+	size_t size; //Size of the mapping in bytes
+#ifdef _WIN32
+	HANDLE file; //File handle
+	HANDLE mapping; //Mapping handle
+#else
+	int fd; //File descriptor
+#endif
+
+public:
+	MappedFile();
+	virtual ~MappedFile();
+
+	/*
+	Maps the whole file for reading, returns false if the file cannot be opened or mapped
+
+	path - file address
+	copyOnWrite - if true, the mapping is writable and modified pages are private copies (the file is not changed)
+	*/
+	bool Open(string path, bool copyOnWrite = false);
+	/*
+	Maps a named shared memory segment created by SharedMemory for reading, returns false if the segment \
+	does not exist or cannot be mapped. Pages are shared with other processes mapping the segment.
+
+	name - name of the segment
+	copyOnWrite - if true, the mapping is writable and modified pages are private copies (the segment is not changed)
+	*/
+	bool OpenShared(string name, bool copyOnWrite = false);
+	/*
+	Unmaps the file
+	*/
+	void Close();
+	/*
+	Returns pointer to the mapped memory (NULL for an empty file)
+	*/
+	const char * GetData() { return data; }
+	/*
+	Returns size of the mapped file in bytes
+	*/
+	size_t GetSize() { return size; }
+};
+
+inline MappedFile::MappedFile()
+{
+	data = NULL;
+	size = 0;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	fd = -1;
+#endif
+}
+
+inline MappedFile::~MappedFile()
+{
+	Close();
+}
+
+inline bool MappedFile::Open(string path, bool copyOnWrite)
+{
+	Close();
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (unsigned long long)fileSize.QuadPart > (size_t)-1) {
+		Close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0)
+		return true;
+
+	mapping = CreateFileMappingA(file, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		Close();
+		return false;
+	}
+	data = (const char *)MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+#else
+	fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		Close();
+		return false;
+	}
+	size = (size_t)st.st_size;
+	if (size == 0)
+		return true;
+
+	void * ptr = mmap(NULL, size, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+	data = (ptr == MAP_FAILED ? NULL : (const char *)ptr);
+	if (data)
+		madvise(ptr, size, MADV_SEQUENTIAL);
+#endif
+
+	if (!data) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+inline bool MappedFile::OpenShared(string name, bool copyOnWrite)
+{
+	Close();
+	name = SharedMemoryName(name);
+
+#ifdef _WIN32
+	mapping = OpenFileMappingA(copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, FALSE, name.c_str());
+	if (mapping == NULL)
+		return false;
+	data = (const char *)MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+
+	//Size of the view is rounded up to whole pages
+	MEMORY_BASIC_INFORMATION info;
+	if (data && VirtualQuery(data, &info, sizeof(info)) == sizeof(info))
+		size = info.RegionSize;
+	else if (data) {
+		UnmapViewOfFile(data);
+		data = NULL;
+	}
+#else
+	fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		Close();
+		return false;
+	}
+	size = (size_t)st.st_size;
+
+	void * ptr = mmap(NULL, size, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, copyOnWrite ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+	data = (ptr == MAP_FAILED ? NULL : (const char *)ptr);
+#endif
+
+	if (!data) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+inline void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (data)
+		munmap((void *)data, size);
+	if (fd >= 0)
+		close(fd);
+	fd = -1;
+#endif
+	data = NULL;
+	size = 0;
+}
+
+/*
+Named shared memory segment created for writing
+
+The segment can be mapped by other processes (MappedFile::OpenShared) while it is open. \
+Closing removes the name, processes which already mapped the segment keep their mappings.
+*/
+class SharedMemory
+{
+private:
+	char * data; //Mapped memory
+	size_t size; //Size of the segment in bytes
+	string name; //Name of the segment
+#ifdef _WIN32
+	HANDLE mapping; //Mapping handle
+#else
+	dev_t device; //Device and inode of the segment, the name is removed only if it still refers to them
+	ino_t inode;
+#endif
+
+public:
+	SharedMemory();
+	virtual ~SharedMemory();
+
+	/*
+	Creates and maps a zero-filled segment, returns false on error or if a segment of the same name exists \
+	(see Remove)
+
+	_name - name of the segment
+	_size - size of the segment in bytes
+	*/
+	bool Create(string _name, size_t _size);
+	/*
+	Unmaps the segment and removes its name (unless the name was removed and reused by another segment)
+	*/
+	void Close();
+	/*
+	Removes the name of a segment (e.g. a stale one left by a crashed process), processes which mapped it \
+	keep their mappings. On Windows, a segment exists while any process holds it, so the name cannot be removed. \
+	Returns false if the name cannot be removed.
+	*/
+	static bool Remove(string name);
+	/*
+	Returns pointer to the mapped memory
+	*/
+	char * GetData() { return data; }
+	/*
+	Returns size of the segment in bytes
+	*/
+	size_t GetSize() { return size; }
+};
+
+inline SharedMemory::SharedMemory()
+{
+	data = NULL;
+	size = 0;
+#ifdef _WIN32
+	mapping = NULL;
+#else
+	device = 0;
+	inode = 0;
+#endif
+}
+
+inline SharedMemory::~SharedMemory()
+{
+	Close();
+}
+
+inline bool SharedMemory::Create(string _name, size_t _size)
+{
+	Close();
+	if (_size == 0)
+		return false;
+	name = SharedMemoryName(_name);
+
+#ifdef _WIN32
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		(DWORD)((unsigned long long)_size >> 32), (DWORD)(_size & 0xFFFFFFFF), name.c_str());
+	if (mapping != NULL && GetLastError() == ERROR_ALREADY_EXISTS) {
+		//The segment is still used by another process
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+	if (mapping == NULL) {
+		name.clear();
+		return false;
+	}
+	data = (char *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+#else
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) {
+		name.clear();
+		return false;
+	}
+	struct stat st;
+	const bool created = (fstat(fd, &st) == 0);
+	if (created) {
+		device = st.st_dev;
+		inode = st.st_ino;
+	}
+	else
+		shm_unlink(name.c_str());
+	if (created && ftruncate(fd, (off_t)_size) == 0) {
+		void * ptr = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		data = (ptr == MAP_FAILED ? NULL : (char *)ptr);
+	}
+	close(fd);
+#endif
+
+	size = _size;
+	if (!data) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+inline bool SharedMemory::Remove(string name)
+{
+#ifdef _WIN32
+	HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, SharedMemoryName(name).c_str());
+	if (mapping == NULL)
+		return true;
+	CloseHandle(mapping);
+	return false;
+#else
+	return shm_unlink(SharedMemoryName(name).c_str()) == 0 || errno == ENOENT;
+#endif
+}
+
+inline void SharedMemory::Close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	mapping = NULL;
+#else
+	if (data)
+		munmap(data, size);
+	if (!name.empty()) {
+		int fd = shm_open(name.c_str(), O_RDONLY, 0);
+		struct stat st;
+		if (fd >= 0 && fstat(fd, &st) == 0 && st.st_dev == device && st.st_ino == inode)
+			shm_unlink(name.c_str());
+		if (fd >= 0)
+			close(fd);
+	}
+#endif
+	name.clear();
+	data = NULL;
+	size = 0;
+}
+
+/*
+Lists files matching a wildcard pattern (* and ? in the file name) sorted by name, returns false on error
+
+pattern - file address with wildcards
+paths - addresses of the files are appended
+*/
+inline bool ListFiles(string pattern, vector<string> & paths)
+{
+	vector<string> found;
+#ifdef _WIN32
+	//Found names are relative to the directory of the pattern
+	size_t slash = pattern.find_last_of("\\/");
+	string dir = (slash == string::npos ? "" : pattern.substr(0, slash + 1));
+
+	WIN32_FIND_DATAA fd;
+	HANDLE h = FindFirstFileA(pattern.c_str(), &fd);
+	if (h == INVALID_HANDLE_VALUE)
+		return (GetLastError() == ERROR_FILE_NOT_FOUND);
+	do {
+		if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			found.push_back(dir + fd.cFileName);
+	} while (FindNextFileA(h, &fd));
+	FindClose(h);
+#else
+	glob_t g;
+	int r = glob(pattern.c_str(), 0, NULL, &g);
+	if (r != 0) {
+		globfree(&g);
+		return (r == GLOB_NOMATCH);
+	}
+	for (size_t i = 0; i < g.gl_pathc; i++) {
+		struct stat st;
+		if (stat(g.gl_pathv[i], &st) == 0 && !S_ISDIR(st.st_mode))
+			found.push_back(g.gl_pathv[i]);
+	}
+	globfree(&g);
+#endif
+
+	sort(found.begin(), found.end());
+	paths.insert(paths.end(), found.begin(), found.end());
+	return true;
+}
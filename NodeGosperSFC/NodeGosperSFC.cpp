@@ -77,15 +77,18 @@ void display(void) {
 	const BB * bb = sfc->GetBB();
 	glScalef(scale, scale, 1.f);
 
+	//Points are in original coordinates, the frame origin is moved to the center of the window
+	const Point origin = sfc->GetFrame().origin;
+
 	if (sfc) {
 		Point3D color(0, 0, 0);
 		const Point * p;
 		glBegin(GL_LINE_STRIP);
 		for (uint i = 0; i < sfc->GetPointNum(); i++) {
 			p = sfc->GetSFCPoint(i);
-			color = colors[(sfc->GetCodes()[i] >> 3 * (level - colorLevel - 1)) & 7];
+			color = colors[(sfc->GetCode(i) >> 3 * (level - colorLevel - 1)) & 7];
 			glColor3f(color.x, color.y, color.z);
-			glVertex2f(p->x, p->y);
+			glVertex2f((float)(p->x - origin.x), (float)(p->y - origin.y));
 		}
 		glEnd();
 	}
@@ -28,6 +28,7 @@
 //
 
 #include "SFC.h"
+#include "IndexFile.h"
 
 //Used constants
 #define F1_SQRT7 0.3779644730092272 // 1 / SQRT(7)
@@ -47,41 +48,71 @@ enum NodeGosperSFC_Type {
 
 #define MAX_LEVEL_NUM 21
 
+//Transformation tables of the center pattern indices to the simple (P2), linear (P3) and snake (P4) patterns
+const int idTransSimple[7] = { 4, 0, 1, 2, 3, 6, 5 };
+const int idTransLinear[7] = { 3, 2, 0, 1, 4, 6, 5 };
+const int idTransSnake[7] = { 3, 4, 0, 1, 2, 6, 5 };
+
+//Precomputed array of circles inscribed into Gosper islands of different levels
+const REAL norm_insc[MAX_LEVEL_NUM] = { 0.755928946000, 0.755928946000, 0.750121467308, 0.746782631146, 0.746782631146, 0.746577727521, 0.746348363909, 0.746348363909, 0.746344578768, 0.746327538283, 0.746327538283, 0.746327538283, 0.746326555879, 0.746326555879, 0.746326555879, 0.746326510616, 0.746326510616, 0.746326510616, 0.746326508597, 0.746326508597, 0.746326508597 };
+
 /*
 Node-Gosper SFC class
 */
 class NodeGosperSFC : public SFC<2> {
 private:
-	//Precomputed array of circles inscribed into Gosper islands of different levels
-	const REAL norm_insc[MAX_LEVEL_NUM] = { 0.755928946000, 0.755928946000, 0.750121467308, 0.746782631146, 0.746782631146, 0.746577727521, 0.746348363909, 0.746348363909, 0.746344578768, 0.746327538283, 0.746327538283, 0.746327538283, 0.746326555879, 0.746326555879, 0.746326555879, 0.746326510616, 0.746326510616, 0.746326510616, 0.746326508597, 0.746326508597, 0.746326508597 };
 	REAL smallHexSize; //Size of hexagons of the deepest level of recursion
-	
+	Point origin; //Center of the root Gosper island
+
 	uint level; //Index of max. level of recursion (i.e. depth-1)
 	PointCloud<2> * pc; //Point cloud object
 	NodeGosperSFC_Type type; //Type of indexation pattern
 
+	CODE * refinedCodes; //Array of lower-level digits of points in refined cells along SFC
+	uint refinedLevels; //Number of refined levels
+
+	PointCloud<2> * ownedPc; //Point cloud owned by an SFC opened from an index file
+	MappedFile * mapping; //Mapping of an opened index file
+	SharedMemory * published; //Shared memory segment of the published index
+
+	/*
+	Node-Gosper SFC of an opened index file using constructed arrays inside the mapping
+	*/
+	NodeGosperSFC(MappedFile * file, PointCloud<2> * _pc, CODE * _codes, uint * _indices, CompressedCodes * _compressed, const IndexFileHeader & header) :
+		SFC(_pc, _codes, _indices, _compressed) {
+		Frame frame;
+		frame.origin = Point(header.origin[0], header.origin[1]);
+		frame.radius = 0.;
+		Init(header.level, _pc, (NodeGosperSFC_Type)header.type, frame);
+		smallHexSize = header.smallHexSize;
+		ownedPc = _pc;
+		mapping = file;
+	}
+
 public:
 	NodeGosperSFC(uint _level, PointCloud<2> * _pc, NodeGosperSFC_Type _type) : SFC(_pc) {
-		//Max. level condition
-		if ((_level + 1) > MAX_LEVEL_NUM) {
-			cout << "ERROR: Level greater than " << (MAX_LEVEL_NUM - 1) << endl;
-			throw 1;
-		}
-
-		level = _level;
-		pc = _pc;
-		type = _type;
+		Init(_level, _pc, _type, BBFrame(_pc->GetBB()));
+	}
+	/*
+	Node-Gosper SFC in a fixed world frame used as-is, codes are comparable among point clouds \
+	sharing the frame, level and type of indexation pattern
 
-		//Computation of the smallHexSize according to BB diagonal which secures that the BB diagonal \
-		fits into the circle inscribed into the Gosper island of required level
-		const BB * bb = pc->GetBB();
-		REAL halfdiag = 0.5f*distance(bb->min, bb->max); //BB diagonal
-		REAL s = halfdiag / norm_insc[level];
-		smallHexSize = s*pow(F1_SQRT7, level);
+	_frame - origin of the root Gosper island and radius of the circle which has to fit into it
+	*/
+	NodeGosperSFC(uint _level, PointCloud<2> * _pc, NodeGosperSFC_Type _type, const Frame & _frame) : SFC(_pc) {
+		Init(_level, _pc, _type, _frame);
 	}
 
 	virtual ~NodeGosperSFC() {
 		pc = 0;
+		delete[] refinedCodes;
+		refinedCodes = NULL;
+		delete ownedPc;
+		ownedPc = NULL;
+		delete mapping;
+		mapping = NULL;
+		delete published;
+		published = NULL;
 	}
 	/*
 	Returns number of bits representing code of one recursive level
@@ -96,25 +127,226 @@ public:
 	*/
 	virtual CODE HashCode(const Point * p);
 	/*
+	Constructs SFC, attribute columns of the point cloud are ordered along SFC and refinement is discarded
+	*/
+	virtual void ConstructSFC();
+	/*
+	Extends the frame upward by k levels of recursion around the origin keeping the size of the smallest hexagon. \
+	The root becomes the center cell of the new levels, so the existing codes are rewritten arithmetically \
+	by prepending the digits of the center cell (full-depth codes are expected, compressed codes are decompressed). \
+	If the order of the precise pattern is reversed, attribute columns are ordered again.
+	*/
+	virtual void ExtendLevels(uint k);
+	/*
+	Hashes the points appended to the point cloud and merges them into the SFC. \
+	The frame is extended by the levels required to cover the appended points.
+	*/
+	virtual void UpdateSFC();
+	/*
+	Computes extraLevels lower-level digits for points of cells holding more than maxPointsPerCell points \
+	and re-sorts points of these cells by them. The digits come from the grid refined by extraLevels levels \
+	of recursion whose Gosper islands nest in the cells (see CheckRefinedCodes), they continue the indexation \
+	pattern of the cell. Attribute columns are ordered again, refinement is discarded by ConstructSFC, ExtendLevels and UpdateSFC.
+
+	Returns number of refined cells
+	*/
+	uint RefineCells(uint maxPointsPerCell, uint extraLevels);
+	/*
+	Returns array of refined codes along SFC (zero for points of cells which were not refined)
+	*/
+	CODE * GetRefinedCodes() { return refinedCodes; }
+	/*
+	Returns number of refined levels (0 = no refinement)
+	*/
+	uint GetRefinedLevels() { return refinedLevels; }
+	/*
+	Checks the refinement made by RefineCells with the same maxPointsPerCell: codes of points of refined cells \
+	followed by their refined digits have to be equal to the codes hashed at level + extraLevels in the refined grid \
+	and sorted. Returns false otherwise.
+	*/
+	bool CheckRefinedCodes(uint maxPointsPerCell);
+	/*
+	Saves the constructed SFC (codes, indices, points, BB, level, type, frame) to an index file (see IndexFile.h). \
+	Codes are stored block-compressed if compressCodes is set or if they are compressed by CompressCodes.
+	*/
+	bool SaveIndex(string path, bool compressCodes = false);
+	/*
+	Opens an index file saved by SaveIndex. The file is mapped and codes, indices and points are used \
+	directly from the mapping (copy-on-write, so updates never modify the file), compressed codes stay \
+	compressed. The returned SFC owns its point cloud. Returns NULL if the file cannot be read.
+	*/
+	static NodeGosperSFC * OpenIndex(string path);
+	/*
+	Publishes the constructed SFC into a named shared memory segment in the layout of the index file, \
+	so that processes on the host share one copy of codes, indices and points (see AttachIndex). \
+	The segment is owned by this SFC, its name is valid until UnpublishIndex or the destructor.
+
+	replace - a segment of the same name published by another SFC (e.g. of a crashed process) is removed, \
+	otherwise publishing fails (see SharedMemory::Remove)
+	*/
+	bool PublishIndex(string name, bool compressCodes = false, bool replace = false);
+	/*
+	Removes the name of the published segment, attached SFCs remain valid
+	*/
+	void UnpublishIndex();
+	/*
+	Attaches an SFC published by PublishIndex (in any process). Codes, indices and points are used \
+	directly from the shared pages (copy-on-write, so updates never modify the segment). \
+	The returned SFC owns its point cloud. Returns NULL if the segment cannot be attached.
+	*/
+	static NodeGosperSFC * AttachIndex(string name);
+	/*
+	Returns radius of the circle inscribed into the root Gosper island (i.e. radius covered by the frame)
+	*/
+	inline REAL GetFrameRadius() {
+		return FrameRadius(smallHexSize, level);
+	}
+	/*
+	Returns frame of the SFC (origin and radius covered by the root Gosper island)
+	*/
+	inline Frame GetFrame() {
+		Frame frame;
+		frame.origin = origin;
+		frame.radius = GetFrameRadius();
+		return frame;
+	}
+	/*
+	Returns frame derived from a BB: the BB center and the half of the BB diagonal
+	*/
+	static inline Frame BBFrame(const BB * bb) {
+		Frame frame;
+		frame.origin = Point(0.5*(bb->min.x + bb->max.x), 0.5*(bb->min.y + bb->max.y));
+		frame.radius = 0.5f*distance(bb->min, bb->max); //BB diagonal
+		return frame;
+	}
+	/*
+	Returns radius of the circle inscribed into the Gosper island of a level for the given size of the smallest hexagon
+	*/
+	static inline REAL FrameRadius(REAL hexSize, uint level) {
+		return norm_insc[level] * hexSize * pow(1.0 / F1_SQRT7, level);
+	}
+	/*
 	Returns size of the smallest hexagon
 	*/
 	inline REAL GetCellSize() {
 		return smallHexSize;
 	}
+	/*
+	Returns index of max. level of recursion
+	*/
+	inline uint GetLevel() {
+		return level;
+	}
+	/*
+	Returns type of indexation pattern
+	*/
+	inline NodeGosperSFC_Type GetType() {
+		return type;
+	}
+	/*
+	Returns size of the smallest hexagon for a frame radius and a level of recursion
+
+	Computation of the smallHexSize according to the frame radius (half of the BB diagonal) which secures \
+	that the circle of the radius fits into the circle inscribed into the Gosper island of required level
+	*/
+	static REAL ComputeCellSize(REAL radius, uint level);
+	/*
+	Returns the smallest level whose cells hold at most maxPointsPerCell points, estimated from \
+	a histogram of center codes of a regular sample of the point cloud
+
+	pc - point cloud object
+	maxPointsPerCell - max. number of points in one cell
+	quantile - min. fraction of points lying in cells which satisfy maxPointsPerCell
+	minCellSize - the level is bounded so that the smallest hexagon is not smaller than minCellSize (0 = no bound)
+	sampleNum - max. number of sampled points
+	*/
+	static uint SelectLevel(PointCloud<2> * pc, uint maxPointsPerCell, REAL quantile = 1.0, REAL minCellSize = 0.0, uint sampleNum = 65536);
+
+protected:
+	/*
+	Returns number of levels the frame has to be extended by to cover the points appended to the point cloud
+	*/
+	uint AppendedLevels();
+	/*
+	Adds k levels above the root keeping the size of the smallest hexagon, the codes are not rewritten \
+	(they have to be hashed again) and refinement is discarded
+	*/
+	void AddLevels(uint k);
 
 private:
+	/*
+	Initializes the SFC for a frame
+	*/
+	void Init(uint _level, PointCloud<2> * _pc, NodeGosperSFC_Type _type, const Frame & _frame);
+	/*
+	Fills the header of the index, returns the codes stored compressed (NULL for plain codes)
+
+	tmpCompressed - storage of codes compressed for the index only
+	*/
+	const CompressedCodes * PrepareIndex(IndexFileHeader & header, bool compressCodes, CompressedCodes & tmpCompressed);
+	/*
+	Returns SFC using arrays of a mapped index (file or shared memory), NULL if the index is not valid
+
+	name - address of the index used in error messages
+	*/
+	static NodeGosperSFC * AttachMapping(MappedFile * file, string name);
 	/*
 	Returns code of a point p using the center indexation pattern (P1)
 
 	reverse - if true it writes the code bits of recursive levels in reverse order, required by HashCodePrecise
 	*/
-	CODE HashCodeCenter(const Point * p, bool reverse = false);
+	CODE HashCodeCenter(const Point * p, bool reverse = false) { return CenterCode(p, origin, smallHexSize, level, reverse); }
+	/*
+	Returns code of a point p using the center indexation pattern (P1) for the given origin, size of the smallest hexagon and level
+	*/
+	static CODE CenterCode(const Point * p, const Point & origin, REAL hexSize, uint level, bool reverse = false);
+	/*
+	Returns cube coordinates of the hexagon of a point p in the deepest grid of the given origin and size of the smallest hexagon
+
+	extraLevels - the grid is refined by extraLevels levels of recursion, i.e. it is rotated and scaled so that \
+	going up extraLevels levels leads exactly to the hexagons of the unrefined grid
+	*/
+	static Int3D LeafCell(const Point * p, const Point & origin, REAL hexSize, uint extraLevels = 0);
+	/*
+	Returns hexagon of decimal cube coordinates
+	*/
+	static Int3D RoundCube(Point3D dc);
+	/*
+	Returns digitNum digits of the center pattern (P1) going up from the hexagon ic, ic is moved to the reached hexagon
+
+	reverse - if true it writes the code bits of recursive levels in reverse order
+	*/
+	static CODE CenterDigits(Int3D & ic, uint digitNum, bool reverse = false);
+	/*
+	Returns hexagon of a point p in the grid refined by extraLevels levels which lies in the Gosper island \
+	of extraLevels levels over the hexagon of p in the unrefined grid
+	*/
+	static Int3D RefinedCell(const Point * p, const Point & origin, REAL hexSize, uint extraLevels);
+	/*
+	Returns fraction of sampled points lying in cells holding at most maxSampleNum sampled points
+	
+	codes - center codes of the sampled points, sorted in place
+	*/
+	static REAL SampleOccupancy(CODE * codes, uint sampleNum, REAL maxSampleNum);
 	/*
 	Returns code of a point p using the precise Node-Gosper indexation pattern (P2) \
 	-  includes additional transformations for continuous SFC
 	*/
 	CODE HashCodePrecise(const Point * p);
 	/*
+	Transforms digitNum digits of a reversed center code to the precise Node-Gosper indexation \
+	continuing from the given index rotation and passage order
+	*/
+	static CODE PreciseDigits(CODE center, uint digitNum, char & rotDir, char & btf);
+	/*
+	Returns index rotation and passage order reached after digitNum digits of a precise code
+	*/
+	static void PreciseState(CODE code, uint digitNum, char & rotDir, char & btf);
+	/*
+	Transforms digitNum digits of a center code by a transformation table of indices
+	*/
+	static CODE TransformCenter(CODE center, uint digitNum, const int idTrans[7]);
+	/*
 	Returns code of a point p using the precise Node-Gosper indexation pattern (P2) \
 	-  without additional transformations for continuous SFC
 	*/
@@ -129,6 +361,118 @@ private:
 	CODE HashCodeSnake(const Point * p);
 };
 
+void NodeGosperSFC::ExtendLevels(uint k)
+{
+	if (k == 0)
+		return;
+
+	if ((level + k + 1) > MAX_LEVEL_NUM) {
+		cout << "ERROR: Level greater than " << (MAX_LEVEL_NUM - 1) << endl;
+		throw 1;
+	}
+
+	//Code digits of the center cell in new levels
+	CODE prefix = 0;
+	CODE complement = 0;
+	uint top = level + k; //Index of the new top level
+	for (uint l = level + 1; l <= top; l++) {
+		switch (type) {
+		case NodeGosperSFC_Simple:
+			prefix |= ((CODE)idTransSimple[0]) << (GetBitShift() * l);
+			break;
+		case NodeGosperSFC_Linear:
+			prefix |= ((CODE)idTransLinear[0]) << (GetBitShift() * l);
+			break;
+		case NodeGosperSFC_Snake:
+			prefix |= ((CODE)idTransSnake[0]) << (GetBitShift() * l);
+			break;
+		case NodeGosperSFC_Precise:
+			//Center cells are forward (4) and backward (2) alternately from the top
+			prefix |= ((CODE)((top - l) % 2 ? 2 : 4)) << (GetBitShift() * l);
+			break;
+		default:
+			break;
+		}
+	}
+	//Odd number of new levels of the precise pattern reverses passage order of the old levels
+	if (type == NodeGosperSFC_Precise && (k % 2)) {
+		for (uint l = 0; l <= level; l++) {
+			complement |= ((CODE)6) << (GetBitShift() * l);
+		}
+	}
+
+	DecompressCodes();
+	CODE * cds = GetCodes();
+	for (uint i = 0; i < GetCodeNum(); i++, cds++) {
+		//Digits are not greater than 6, so 6-digit is computed without borrows
+		*cds = prefix | (complement ? complement - *cds : *cds);
+	}
+
+	//Reversed passage order of the old levels reverses the sorted arrays
+	if (complement) {
+		CODE * cl = GetCodes(), * cr = GetCodes() + GetCodeNum() - 1, tmpC;
+		uint * il = GetIndices(), * ir = GetIndices() + GetCodeNum() - 1, tmpI;
+		for (; cl < cr; cl++, cr--, il++, ir--) {
+			tmpC = *cl; *cl = *cr; *cr = tmpC;
+			tmpI = *il; *il = *ir; *ir = tmpI;
+		}
+
+		//Attribute columns follow the order (appended points are ordered by UpdateSFC)
+		if (GetCodeNum() == GetPointNum())
+			pc->OrderAttributes(GetIndices());
+	}
+
+	AddLevels(k);
+}
+
+void NodeGosperSFC::ConstructSFC()
+{
+	SFC::ConstructSFC();
+
+	delete[] refinedCodes;
+	refinedCodes = NULL;
+	refinedLevels = 0;
+}
+
+void NodeGosperSFC::UpdateSFC()
+{
+	ExtendLevels(AppendedLevels());
+	SFC::UpdateSFC();
+
+	delete[] refinedCodes;
+	refinedCodes = NULL;
+	refinedLevels = 0;
+}
+
+uint NodeGosperSFC::AppendedLevels()
+{
+	//Levels required to cover the appended points
+	const Point * pts = pc->GetArray();
+	REAL radius = 0.;
+	for (uint i = GetCodeNum(); i < GetPointNum(); i++) {
+		REAL r = distance(pts[i], origin);
+		radius = (r > radius ? r : radius);
+	}
+
+	uint k = 0;
+	while (radius > FrameRadius(smallHexSize, level + k)) {
+		if ((level + k + 2) > MAX_LEVEL_NUM) {
+			cout << "ERROR: Level greater than " << (MAX_LEVEL_NUM - 1) << endl;
+			throw 1;
+		}
+		k++;
+	}
+	return k;
+}
+
+void NodeGosperSFC::AddLevels(uint k)
+{
+	delete[] refinedCodes;
+	refinedCodes = NULL;
+	refinedLevels = 0;
+	level += k;
+}
+
 CODE NodeGosperSFC :: HashCode(const Point * p) {
 	switch (type) {
 	case NodeGosperSFC_Center:
@@ -151,24 +495,314 @@ CODE NodeGosperSFC :: HashCode(const Point * p) {
 	}
 }
 
-CODE NodeGosperSFC :: HashCodeCenter(const Point * p, bool reverse)
+void NodeGosperSFC::Init(uint _level, PointCloud<2> * _pc, NodeGosperSFC_Type _type, const Frame & _frame)
 {
-	Point3D dc; //Decimal cube coordinates
-	Int3D ic; //Integer cube coordinates
+	//Max. level condition
+	if ((_level + 1) > MAX_LEVEL_NUM) {
+		cout << "ERROR: Level greater than " << (MAX_LEVEL_NUM - 1) << endl;
+		throw 1;
+	}
 
-	int sign; //Sign of decimal residue
-	int dominant; //Index of dominant axis
-	CODE hexc = 0; //Final hash code
-	CODE mini; //Hexagon index according to the center pattern
+	level = _level;
+	pc = _pc;
+	type = _type;
+	refinedCodes = NULL;
+	refinedLevels = 0;
+	ownedPc = NULL;
+	mapping = NULL;
+	published = NULL;
 
-	//Array for mapping points onto the center pattern index
-	const int arr[2][3] = { { 5, 1, 3 },{ 2, 4, 6 } };
+	origin = _frame.origin;
+	smallHexSize = ComputeCellSize(_frame.radius, level);
+}
+
+const CompressedCodes * NodeGosperSFC::PrepareIndex(IndexFileHeader & header, bool compressCodes, CompressedCodes & tmpCompressed)
+{
+	//Codes compressed for the index only
+	const CompressedCodes * cc = GetCompressedCodes();
+	if (compressCodes && !cc) {
+		tmpCompressed.Compress(GetCodes(), GetCodeNum());
+		cc = &tmpCompressed;
+	}
+
+	header.dimension = 2;
+	header.type = type;
+	header.level = level;
+	header.count = GetCodeNum();
+	header.smallHexSize = smallHexSize;
+	if (cc) {
+		header.flags |= INDEX_FILE_COMPRESSED_CODES;
+		header.codesSize = cc->GetSize();
+	}
+	const BB * bb = pc->GetBB();
+	for (uint d = 0; d < 2; d++) {
+		header.origin[d] = origin.arr[d];
+		header.bbMin[d] = (bb ? bb->min.arr[d] : 0.);
+		header.bbMax[d] = (bb ? bb->max.arr[d] : 0.);
+		header.center[d] = pc->GetCenter().arr[d];
+	}
+	return cc;
+}
 
+bool NodeGosperSFC::SaveIndex(string path, bool compressCodes)
+{
+	if (GetCodeNum() != GetPointNum()) {
+		cout << "ERROR: SFC has to be constructed before saving" << endl;
+		return false;
+	}
+
+	IndexFileHeader header;
+	CompressedCodes tmpCompressed;
+	const CompressedCodes * cc = PrepareIndex(header, compressCodes, tmpCompressed);
+	unsigned long long size = header.Layout();
+
+	FILE * f = fopen(path.c_str(), "wb");
+	if (!f) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+	setvbuf(f, NULL, _IOFBF, 1 << 22);
+
+	//Sections padded to their aligned offsets
+	const char zeros[INDEX_FILE_ALIGNMENT] = { 0 };
+	unsigned long long pos = 0;
+	const void * sections[4] = { &header, (cc ? NULL : GetCodes()), GetIndices(), pc->GetArray() };
+	const unsigned long long offsets[4] = { 0, header.codesOffset, header.indicesOffset, header.pointsOffset };
+	const unsigned long long sizes[4] = { sizeof(IndexFileHeader), (cc ? header.codesSize : header.count * sizeof(CODE)),
+		header.count * sizeof(uint), header.count * sizeof(Point) };
+	bool ok = true;
+	for (int s = 0; s < 4 && ok; s++) {
+		ok = (fwrite(zeros, 1, (size_t)(offsets[s] - pos), f) == offsets[s] - pos);
+		if (s == 1 && cc)
+			ok = ok && cc->Write(f);
+		else
+			ok = ok && (sizes[s] == 0 || fwrite(sections[s], (size_t)sizes[s], 1, f) == 1);
+		pos = offsets[s] + sizes[s];
+	}
+
+	ok = (fclose(f) == 0) && ok && pos == size;
+	if (!ok)
+		cout << "Error while writing file " << path << "." << endl;
+	return ok;
+}
+
+NodeGosperSFC * NodeGosperSFC::OpenIndex(string path)
+{
+	MappedFile * file = new MappedFile();
+	if (!file->Open(path, true)) {
+		delete file;
+		cout << "File " << path << " cannot be opened." << endl;
+		return NULL;
+	}
+	return AttachMapping(file, path);
+}
+
+bool NodeGosperSFC::PublishIndex(string name, bool compressCodes, bool replace)
+{
+	if (GetCodeNum() != GetPointNum()) {
+		cout << "ERROR: SFC has to be constructed before publishing" << endl;
+		return false;
+	}
+
+	IndexFileHeader header;
+	CompressedCodes tmpCompressed;
+	const CompressedCodes * cc = PrepareIndex(header, compressCodes, tmpCompressed);
+	const unsigned long long size = header.Layout();
+
+	//The previous segment is removed before its name is reused
+	UnpublishIndex();
+	if (replace && !SharedMemory::Remove(name)) {
+		cout << "Shared memory " << name << " cannot be removed." << endl;
+		return false;
+	}
+	SharedMemory * segment = new SharedMemory();
+	if (size > (size_t)-1 || !segment->Create(name, (size_t)size)) {
+		delete segment;
+		cout << "Shared memory " << name << " cannot be created." << endl;
+		return false;
+	}
+
+	//Sections copied to their aligned offsets of the zero-filled segment
+	char * base = segment->GetData();
+	memcpy(base, &header, sizeof(IndexFileHeader));
+	if (cc)
+		cc->Write(base + header.codesOffset);
+	else if (header.count)
+		memcpy(base + header.codesOffset, GetCodes(), (size_t)header.count * sizeof(CODE));
+	if (header.count) {
+		memcpy(base + header.indicesOffset, GetIndices(), (size_t)header.count * sizeof(uint));
+		memcpy(base + header.pointsOffset, pc->GetArray(), (size_t)header.count * sizeof(Point));
+	}
+
+	published = segment;
+	return true;
+}
+
+void NodeGosperSFC::UnpublishIndex()
+{
+	delete published;
+	published = NULL;
+}
+
+NodeGosperSFC * NodeGosperSFC::AttachIndex(string name)
+{
+	MappedFile * file = new MappedFile();
+	if (!file->OpenShared(name, true)) {
+		delete file;
+		cout << "Shared memory " << name << " cannot be attached." << endl;
+		return NULL;
+	}
+	return AttachMapping(file, name);
+}
+
+NodeGosperSFC * NodeGosperSFC::AttachMapping(MappedFile * file, string name)
+{
+	const IndexFileHeader * header = (const IndexFileHeader *)file->GetData();
+	if (file->GetSize() < sizeof(IndexFileHeader) || !header->IsValid(file->GetSize()) ||
+		header->dimension != 2 || header->type > NodeGosperSFC_Snake || (header->level + 1) > MAX_LEVEL_NUM) {
+		delete file;
+		cout << "Error while reading file " << name << "." << endl;
+		return NULL;
+	}
+
+	//Indices of a corrupt file would address points outside the mapping
+	char * base = (char *)file->GetData();
+	const uint * indices = (const uint *)(base + header->indicesOffset);
+	uint i = 0;
+	while (i < header->count && indices[i] < header->count)
+		i++;
+	if (i < header->count) {
+		delete file;
+		cout << "Error while reading file " << name << "." << endl;
+		return NULL;
+	}
+
+	BB bb;
+	Point center;
+	for (uint d = 0; d < 2; d++) {
+		bb.min.arr[d] = header->bbMin[d];
+		bb.max.arr[d] = header->bbMax[d];
+		center.arr[d] = header->center[d];
+	}
+
+	//Compressed codes inside the mapping
+	IndexFileHeader h = *header;
+	CompressedCodes * cc = NULL;
+	if (h.flags & INDEX_FILE_COMPRESSED_CODES) {
+		cc = new CompressedCodes();
+		if (!cc->Attach(base + h.codesOffset, (size_t)h.codesSize) || cc->GetNum() != h.count) {
+			delete cc;
+			delete file;
+			cout << "Error while reading file " << name << "." << endl;
+			return NULL;
+		}
+	}
+
+	//Point cloud and arrays of the SFC inside the mapping
+	PointCloud<2> * cloud = new PointCloud<2>();
+	cloud->AttachArray((Point *)(base + h.pointsOffset), (uint)h.count, bb, center);
+	return new NodeGosperSFC(file, cloud, (cc ? NULL : (CODE *)(base + h.codesOffset)), (uint *)(base + h.indicesOffset), cc, h);
+}
+
+REAL NodeGosperSFC::ComputeCellSize(REAL radius, uint level)
+{
+	REAL s = radius / norm_insc[level];
+	return s*pow(F1_SQRT7, level);
+}
+
+uint NodeGosperSFC::SelectLevel(PointCloud<2> * pc, uint maxPointsPerCell, REAL quantile, REAL minCellSize, uint sampleNum)
+{
+	const uint n = pc->GetPointNum();
+	if (n == 0 || sampleNum == 0)
+		return 0;
+	if (sampleNum > n)
+		sampleNum = n;
+
+	//Regular sample of the point cloud
+	const Frame frame = BBFrame(pc->GetBB());
+	const Point * pts = pc->GetArray();
+	Point * sample = new Point[sampleNum];
+	for (uint i = 0; i < sampleNum; i++) {
+		sample[i] = pts[(uint)(((unsigned long long)i * n) / sampleNum)];
+	}
+
+	//Limit of points per cell rescaled to the sample
+	REAL maxSampleNum = (REAL)maxPointsPerCell * sampleNum / n;
+	if (maxSampleNum < 1.0)
+		maxSampleNum = 1.0;
+
+	//The deepest level allowed by the min. cell size
+	int maxLevel = MAX_LEVEL_NUM - 1;
+	while (maxLevel > 0 && ComputeCellSize(frame.radius, maxLevel) < minCellSize)
+		maxLevel--;
+
+	//Binary search of the smallest level satisfying the quantile, the occupancy decreases with the level
+	CODE * codes = new CODE[sampleNum];
+	int lo = 0, hi = maxLevel;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		REAL hexSize = ComputeCellSize(frame.radius, mid);
+		for (uint i = 0; i < sampleNum; i++) {
+			codes[i] = CenterCode(sample + i, frame.origin, hexSize, mid);
+		}
+
+		if (SampleOccupancy(codes, sampleNum, maxSampleNum) >= quantile)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	delete[] codes;
+	delete[] sample;
+	return (uint)lo;
+}
+
+REAL NodeGosperSFC::SampleOccupancy(CODE * codes, uint sampleNum, REAL maxSampleNum)
+{
+	Sorting<CODE, uint>::quickSort(codes, 0, ((int)sampleNum) - 1);
+
+	//Histogram of codes given by runs of equal codes
+	uint satisfied = 0;
+	uint first = 0;
+	for (uint i = 1; i <= sampleNum; i++) {
+		if (i == sampleNum || codes[i] != codes[first]) {
+			if ((i - first) <= maxSampleNum)
+				satisfied += i - first;
+			first = i;
+		}
+	}
+
+	return (REAL)satisfied / sampleNum;
+}
+
+CODE NodeGosperSFC :: CenterCode(const Point * p, const Point & origin, REAL hexSize, uint level, bool reverse)
+{
 	//Localization of a point p in the deepest hexagonal grid
-	dc.x = (p->x * SQRT3_3 - p->y * F1_3) / smallHexSize;
-	dc.z = p->y * F2_3 / smallHexSize;
+	Int3D ic = LeafCell(p, origin, hexSize);
+	return CenterDigits(ic, level + 1, reverse);
+}
+
+Int3D NodeGosperSFC::LeafCell(const Point * p, const Point & origin, REAL hexSize, uint extraLevels)
+{
+	Point3D dc; //Decimal cube coordinates
+	const REAL px = p->x - origin.x, py = p->y - origin.y;
+	dc.x = (px * SQRT3_3 - py * F1_3) / hexSize;
+	dc.z = py * F2_3 / hexSize;
+
+	//Inverse transformation between hierarchical levels (a center of a hexagon to the center of its center child)
+	for (uint l = 0; l < extraLevels; l++) {
+		REAL x = dc.x;
+		dc.x = x + x + x + dc.z;
+		dc.z = dc.z + dc.z - x;
+	}
 	dc.y = -dc.x - dc.z;
 
+	return RoundCube(dc);
+}
+
+Int3D NodeGosperSFC::RoundCube(Point3D dc)
+{
+	Int3D ic; //Integer cube coordinates
 	ic.x = RND(dc.x);
 	ic.y = RND(dc.y);
 	ic.z = RND(dc.z);
@@ -184,8 +818,22 @@ CODE NodeGosperSFC :: HashCodeCenter(const Point * p, bool reverse)
 	else
 		ic.z = -ic.x - ic.y; //z is the greatest
 
+	return ic;
+}
+
+CODE NodeGosperSFC::CenterDigits(Int3D & ic, uint digitNum, bool reverse)
+{
+	Point3D dc; //Decimal cube coordinates
+	int sign; //Sign of decimal residue
+	int dominant; //Index of dominant axis
+	CODE hexc = 0; //Final hash code
+	CODE mini; //Hexagon index according to the center pattern
+
+	//Array for mapping points onto the center pattern index
+	const int arr[2][3] = { { 5, 1, 3 },{ 2, 4, 6 } };
+
 	//Loop through the hierarchy in the bottom-up manner
-	for (int l = 0; l <= level; l++) {
+	for (int l = 0; l < (int)digitNum; l++) {
 		if (reverse)
 			hexc <<= 3;
 		
@@ -231,53 +879,66 @@ CODE NodeGosperSFC :: HashCodeCenter(const Point * p, bool reverse)
 	return hexc;
 }
 
-CODE NodeGosperSFC::HashCodeSimple(const Point * p)
+Int3D NodeGosperSFC::RefinedCell(const Point * p, const Point & origin, REAL hexSize, uint extraLevels)
 {
-	//Transformation table for the simple pattern (P2)
-	const int idTrans[7] = { 4, 0, 1, 2, 3, 6, 5 };
+	Int3D parent = LeafCell(p, origin, hexSize);
+	Int3D cell = LeafCell(p, origin, hexSize, extraLevels);
+	Int3D up = cell;
+	CenterDigits(up, extraLevels);
+	if (up.x == parent.x && up.z == parent.z)
+		return cell;
 
-	//Transform the indexation of the center pattern to the simple pattern
-	CODE center = HashCodeCenter(p);
-	CODE hexc = 0U;
-	CODE id;
-	for (int l = 0; l <= level; l++) {
-		id = center & GetBitAndMask();
-		center >>= GetBitShift();
-		id = idTrans[id];
-		hexc |= id << (l + l + l);
+	//The point lies in the hexagon but outside of its Gosper island,
+	//the first refined hexagon of the island on the line to the center of the island is taken
+	Point3D center((REAL)parent.x, 0., (REAL)parent.z);
+	for (uint l = 0; l < extraLevels; l++) {
+		REAL x = center.x;
+		center.x = x + x + x + center.z;
+		center.z = center.z + center.z - x;
 	}
+	center.y = -center.x - center.z;
 
-	return hexc;
+	Int dist = 0;
+	for (uint d = 0; d < 3; d++) {
+		Int diff = cell.arr[d] - (Int)center.arr[d];
+		diff = (diff < 0 ? -diff : diff);
+		dist = (diff > dist ? diff : dist);
+	}
+	for (Int k = 1; k <= dist; k++) {
+		REAL t = (REAL)k / dist;
+		Point3D dc(cell.x + t * (center.x - cell.x), cell.y + t * (center.y - cell.y), cell.z + t * (center.z - cell.z));
+		Int3D c = RoundCube(dc);
+		up = c;
+		CenterDigits(up, extraLevels);
+		if (up.x == parent.x && up.z == parent.z)
+			return c;
+	}
+	return cell;
+}
+
+CODE NodeGosperSFC::HashCodeSimple(const Point * p)
+{
+	//Transform the indexation of the center pattern to the simple pattern
+	return TransformCenter(HashCodeCenter(p), level + 1, idTransSimple);
 }
 CODE NodeGosperSFC::HashCodeLinear(const Point * p)
 {
-	//Transformation table for the linear pattern (P3)
-	const int idTrans[7] = { 3, 2, 0, 1, 4, 6, 5 };
-
 	//Transform the indexation of the center pattern to the linear pattern
-	CODE center = HashCodeCenter(p);
-	CODE hexc = 0;
-	CODE id;
-	for (int l = 0; l <= level; l++) {
-		id = center & GetBitAndMask();
-		center >>= GetBitShift();
-		id = idTrans[id];
-		hexc |= id << (l + l + l);
-	}
-	return hexc;
+	return TransformCenter(HashCodeCenter(p), level + 1, idTransLinear);
 }
 CODE NodeGosperSFC::HashCodeSnake(const Point * p)
 {
-	//Transformation table for the linear pattern (P4)
-	const int idTrans[7] = { 3, 4, 0, 1, 2, 6, 5 };
-
 	//Transform the indexation of the center pattern to the snake pattern
-	CODE center = HashCodeCenter(p);
+	return TransformCenter(HashCodeCenter(p), level + 1, idTransSnake);
+}
+
+CODE NodeGosperSFC::TransformCenter(CODE center, uint digitNum, const int idTrans[7])
+{
 	CODE hexc = 0;
 	CODE id;
-	for (int l = 0; l <= level; l++) {
-		id = center & GetBitAndMask();
-		center >>= GetBitShift();
+	for (int l = 0; l < (int)digitNum; l++) {
+		id = center & 7;
+		center >>= 3;
 		id = idTrans[id];
 		hexc |= id << (l + l + l);
 	}
@@ -286,22 +947,25 @@ CODE NodeGosperSFC::HashCodeSnake(const Point * p)
 
 CODE NodeGosperSFC::HashCodePrecise(const Point * p)
 {
-	//Transformation table for the simple pattern (P2)
-	const int idTrans[7] = { 4, 0, 1, 2, 3, 6, 5 };
 	CODE center = HashCodeCenter(p, true); //Center code
+	char rotDir = 0; // Index rotation: -1 (-120), 0, 1 (+120)
+	char btf = 0; //Passage order: 0 - F (forward), 1 - B (backward)
 
+	return PreciseDigits(center, level + 1, rotDir, btf);
+}
+
+CODE NodeGosperSFC::PreciseDigits(CODE center, uint digitNum, char & rotDir, char & btf)
+{
 	//Transform the indexation of the center pattern to the precise Node-Gosper indexation using the simple pattern
 	CODE hexc = 0; //Final hash code
 	int mini = 0; //Hexagon index in a pattern
-	char rotDir = 0; // Index rotation: -1 (-120), 0, 1 (+120)
-	char btf = 0; //Passage order: 0 - F (forward), 1 - B (backward)
 	
 	//Loop through the hierarchy in the top-down manner
-	for (int l = 0; l <= level; l++) {
+	for (int l = 0; l < (int)digitNum; l++) {
 		//Unmask center pattern index
-		hexc <<= GetBitShift();
-		mini = center & GetBitAndMask();
-		center >>= GetBitShift();
+		hexc <<= 3;
+		mini = center & 7;
+		center >>= 3;
 
 		//Rotate index
 		if (mini && rotDir) {
@@ -311,7 +975,7 @@ CODE NodeGosperSFC::HashCodePrecise(const Point * p)
 		}
 
 		//Transform the center pattern index to the simple pattern index
-		mini = idTrans[mini];
+		mini = idTransSimple[mini];
 
 		//Compute index rotation
 		if ((mini == 0 || mini == 3) && --rotDir < -1) {
@@ -329,4 +993,146 @@ CODE NodeGosperSFC::HashCodePrecise(const Point * p)
 	}
 
 	return hexc;
-}
\ No newline at end of file
+}
+
+void NodeGosperSFC::PreciseState(CODE code, uint digitNum, char & rotDir, char & btf)
+{
+	int mini; //Hexagon index in the simple pattern
+	rotDir = 0;
+	btf = 0;
+
+	//Replay the state changes of PreciseDigits in the top-down manner
+	for (int l = (int)digitNum - 1; l >= 0; l--) {
+		mini = (code >> (l + l + l)) & 7;
+		mini = (btf ? 6 - mini : mini);
+
+		if ((mini == 0 || mini == 3) && --rotDir < -1) {
+			rotDir = 1;
+		}
+		else if (mini == 5 && ++rotDir > 1) {
+			rotDir = -1;
+		}
+
+		if (mini == 0 || mini == 4 || mini == 5)
+			btf = !btf;
+	}
+}
+
+uint NodeGosperSFC::RefineCells(uint maxPointsPerCell, uint extraLevels)
+{
+	if (extraLevels == 0 || (level + extraLevels + 1) > MAX_LEVEL_NUM) {
+		cout << "ERROR: Number of refined levels has to be in range 1 - " << (MAX_LEVEL_NUM - 1 - level) << endl;
+		throw 1;
+	}
+
+	delete[] refinedCodes;
+	refinedCodes = new CODE[GetCodeNum()];
+	refinedLevels = extraLevels;
+
+	uint * indices = GetIndices();
+	const Point * pts = pc->GetArray();
+
+	uint cellNum = 0;
+	uint first = 0;
+	CODE code = (GetCodeNum() > 0 ? GetCode(0) : 0);
+	for (uint i = 1; i <= GetCodeNum(); i++) {
+		const CODE next = (i < GetCodeNum() ? GetCode(i) : 0);
+		if (i < GetCodeNum() && next == code)
+			continue;
+
+		if ((i - first) <= maxPointsPerCell) {
+			for (uint j = first; j < i; j++) {
+				refinedCodes[j] = 0;
+			}
+		}
+		else {
+			//Lower-level digits continue the pattern of the cell
+			char rotDir, btf;
+			if (type == NodeGosperSFC_Precise)
+				PreciseState(code, level + 1, rotDir, btf);
+
+			for (uint j = first; j < i; j++) {
+				//Hexagon of the refined grid nested in the cell
+				Int3D cell = RefinedCell(pts + indices[j], origin, smallHexSize, extraLevels);
+				switch (type) {
+				case NodeGosperSFC_Precise: {
+					char r = rotDir, b = btf;
+					refinedCodes[j] = PreciseDigits(CenterDigits(cell, extraLevels, true), extraLevels, r, b);
+					break;
+				}
+				case NodeGosperSFC_Simple:
+					refinedCodes[j] = TransformCenter(CenterDigits(cell, extraLevels), extraLevels, idTransSimple);
+					break;
+				case NodeGosperSFC_Linear:
+					refinedCodes[j] = TransformCenter(CenterDigits(cell, extraLevels), extraLevels, idTransLinear);
+					break;
+				case NodeGosperSFC_Snake:
+					refinedCodes[j] = TransformCenter(CenterDigits(cell, extraLevels), extraLevels, idTransSnake);
+					break;
+				default:
+					refinedCodes[j] = CenterDigits(cell, extraLevels);
+				}
+			}
+
+			//Re-sort only the run of the cell
+			Sorting<CODE, uint>::quickSort(refinedCodes, indices, (int)first, ((int)i) - 1);
+			cellNum++;
+		}
+
+		first = i;
+		code = next;
+	}
+
+	if (cellNum > 0)
+		pc->OrderAttributes(indices);
+	return cellNum;
+}
+
+bool NodeGosperSFC::CheckRefinedCodes(uint maxPointsPerCell)
+{
+	if (!refinedCodes)
+		return true;
+
+	const uint digitNum = level + refinedLevels + 1;
+	const uint * indices = GetIndices();
+	const Point * pts = pc->GetArray();
+
+	uint first = 0;
+	CODE code = (GetCodeNum() > 0 ? GetCode(0) : 0);
+	for (uint i = 1; i <= GetCodeNum(); i++) {
+		const CODE next = (i < GetCodeNum() ? GetCode(i) : 0);
+		if (i < GetCodeNum() && next == code)
+			continue;
+
+		for (uint j = first; (i - first) > maxPointsPerCell && j < i; j++) {
+			//Full hash of the refined hexagon
+			Int3D cell = RefinedCell(pts + indices[j], origin, smallHexSize, refinedLevels);
+			CODE full;
+			switch (type) {
+			case NodeGosperSFC_Precise: {
+				char r = 0, b = 0;
+				full = PreciseDigits(CenterDigits(cell, digitNum, true), digitNum, r, b);
+				break;
+			}
+			case NodeGosperSFC_Simple:
+				full = TransformCenter(CenterDigits(cell, digitNum), digitNum, idTransSimple);
+				break;
+			case NodeGosperSFC_Linear:
+				full = TransformCenter(CenterDigits(cell, digitNum), digitNum, idTransLinear);
+				break;
+			case NodeGosperSFC_Snake:
+				full = TransformCenter(CenterDigits(cell, digitNum), digitNum, idTransSnake);
+				break;
+			default:
+				full = CenterDigits(cell, digitNum);
+			}
+
+			if (full != ((code << (GetBitShift() * refinedLevels)) | refinedCodes[j]) || (j > first && refinedCodes[j] < refinedCodes[j - 1]))
+				return false;
+		}
+
+		first = i;
+		code = next;
+	}
+	return true;
+}
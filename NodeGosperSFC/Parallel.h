@@ -0,0 +1,77 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "common.h"
+
+/*
+Returns number of threads to use, 0 means all hardware threads
+*/
+inline uint ThreadNum(uint threads)
+{
+	if (threads == 0)
+		threads = thread::hardware_concurrency();
+	return (threads == 0 ? 1 : threads);
+}
+
+/*
+Calls f(i) for all i in [0, num) using up to the given number of threads, the calling thread takes part
+
+num - number of tasks
+f - function of a task index
+threads - max. number of threads (0 = all hardware threads)
+*/
+template <class F> void ParallelFor(uint num, F f, uint threads = 0)
+{
+	threads = ThreadNum(threads);
+	if (threads > num)
+		threads = num;
+
+	if (threads <= 1) {
+		for (uint i = 0; i < num; i++)
+			f(i);
+		return;
+	}
+
+	//Tasks are taken dynamically, chunks of the work may differ in cost
+	atomic<uint> next(0);
+	auto worker = [&]() {
+		for (uint i = next++; i < num; i = next++)
+			f(i);
+	};
+
+	vector<thread> pool;
+	for (uint t = 1; t < threads; t++)
+		pool.push_back(thread(worker));
+	worker();
+	for (uint t = 0; t < pool.size(); t++)
+		pool[t].join();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "common.h"
+
+/*
+Blocking queue of limited capacity connecting stages of a pipeline running on different threads
+
+Producers wait while the queue is full, so memory of the pipeline is bounded by capacities of its queues.
+*/
+template <class T> class BoundedQueue
+{
+private:
+	deque<T> items; //Queued items
+	size_t capacity; //Max. number of items
+	bool closed; //No more items will be pushed
+	mutex lock; //Lock of the queue
+	condition_variable notFull, notEmpty; //Signals of waiting producers and consumers
+
+public:
+	BoundedQueue(size_t _capacity) : capacity(_capacity > 0 ? _capacity : 1), closed(false) {}
+
+	/*
+	Appends an item, waits while the queue is full. Returns false if the queue is closed.
+	*/
+	bool Push(const T & item) {
+		unique_lock<mutex> guard(lock);
+		notFull.wait(guard, [this]() { return closed || items.size() < capacity; });
+		if (closed)
+			return false;
+		items.push_back(item);
+		notEmpty.notify_one();
+		return true;
+	}
+	/*
+	Removes the first item, waits while the queue is empty. Returns false if the queue is closed and empty.
+	*/
+	bool Pop(T & item) {
+		unique_lock<mutex> guard(lock);
+		notEmpty.wait(guard, [this]() { return closed || !items.empty(); });
+		if (items.empty())
+			return false;
+		item = items.front();
+		items.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+	/*
+	Closes the queue, waiting producers and consumers of an empty queue are released
+	*/
+	void Close() {
+		lock_guard<mutex> guard(lock);
+		closed = true;
+		notFull.notify_all();
+		notEmpty.notify_all();
+	}
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include "common.h"
+
+/*
+Header of a PLY file (ascii, binary_little_endian and binary_big_endian formats)
+
+Elements are stored one after another from dataOffset. Records of an element without list properties \
+have a fixed size in binary formats, in the ascii format each record is one line of values.
+*/
+
+enum PlyFormat {
+	PlyFormat_Ascii,
+	PlyFormat_BinaryLittleEndian,
+	PlyFormat_BinaryBigEndian
+};
+
+enum PlyType {
+	PlyType_Int8,
+	PlyType_UInt8,
+	PlyType_Int16,
+	PlyType_UInt16,
+	PlyType_Int32,
+	PlyType_UInt32,
+	PlyType_Float32,
+	PlyType_Float64,
+	PlyType_Invalid
+};
+
+//Property of an element
+struct PlyProperty
+{
+	string name; //Name of the property
+	PlyType type; //Type of the value (type of items of a list)
+	bool list; //Property is a list
+	PlyType countType; //Type of the number of items of a list
+	uint offset; //Offset of the value in a binary record of fixed size
+};
+
+//Element (e.g. vertex or face) and its properties
+struct PlyElement
+{
+	string name; //Name of the element
+	unsigned long long count; //Number of records
+	vector<PlyProperty> properties; //Properties of records
+	uint recordSize; //Size of a binary record (0 if the record has list properties)
+
+	/*
+	Returns index of the property of the given name, -1 if there is none
+	*/
+	int FindProperty(const string & propertyName) const {
+		for (size_t i = 0; i < properties.size(); i++) {
+			if (properties[i].name == propertyName)
+				return (int)i;
+		}
+		return -1;
+	}
+};
+
+struct PlyHeader
+{
+	PlyFormat format; //Format of the data
+	vector<PlyElement> elements; //Elements in the order of storage
+	size_t dataOffset; //Offset of the data behind the header
+
+	/*
+	Reads the header from the beginning of a file, returns false if the header is not valid
+	*/
+	bool Read(const char * data, size_t size) {
+		elements.clear();
+		if (size < 4 || memcmp(data, "ply", 3) != 0)
+			return false;
+
+		//Lines of the header up to end_header, data start behind it
+		string text;
+		const char * it = data, * end = data + size;
+		while (true) {
+			const char * nl = (const char *)memchr(it, '\n', (size_t)(end - it));
+			if (!nl)
+				return false;
+			string line(it, (nl > it && nl[-1] == '\r') ? nl - 1 : nl);
+			it = nl + 1;
+			if (line.compare(0, 10, "end_header") == 0)
+				break;
+			text += line + '\n';
+		}
+		dataOffset = (size_t)(it - data);
+
+		istringstream lines(text);
+		string line;
+		bool hasFormat = false;
+		while (getline(lines, line)) {
+			istringstream words(line);
+			string keyword;
+			words >> keyword;
+			if (keyword == "format") {
+				string f;
+				words >> f;
+				if (f == "ascii")
+					format = PlyFormat_Ascii;
+				else if (f == "binary_little_endian")
+					format = PlyFormat_BinaryLittleEndian;
+				else if (f == "binary_big_endian")
+					format = PlyFormat_BinaryBigEndian;
+				else
+					return false;
+				hasFormat = true;
+			}
+			else if (keyword == "element") {
+				PlyElement e;
+				if (!(words >> e.name >> e.count))
+					return false;
+				e.recordSize = 0;
+				elements.push_back(e);
+			}
+			else if (keyword == "property") {
+				if (elements.empty())
+					return false;
+				PlyProperty p;
+				p.countType = PlyType_Invalid;
+				p.offset = 0;
+				string type;
+				words >> type;
+				p.list = (type == "list");
+				if (p.list) {
+					string countType;
+					words >> countType >> type;
+					p.countType = ParseType(countType);
+					if (p.countType == PlyType_Invalid)
+						return false;
+				}
+				p.type = ParseType(type);
+				if (p.type == PlyType_Invalid || !(words >> p.name))
+					return false;
+				elements.back().properties.push_back(p);
+			}
+		}
+
+		//Offsets of values in binary records of fixed size
+		for (size_t e = 0; e < elements.size(); e++) {
+			uint offset = 0;
+			bool fixed = true;
+			for (size_t i = 0; i < elements[e].properties.size(); i++) {
+				PlyProperty & p = elements[e].properties[i];
+				p.offset = offset;
+				fixed = fixed && !p.list;
+				offset += TypeSize(p.type);
+			}
+			elements[e].recordSize = (fixed ? offset : 0);
+		}
+		return hasFormat;
+	}
+	/*
+	Returns index of the element of the given name, -1 if there is none
+	*/
+	int FindElement(const string & elementName) const {
+		for (size_t i = 0; i < elements.size(); i++) {
+			if (elements[i].name == elementName)
+				return (int)i;
+		}
+		return -1;
+	}
+	/*
+	Returns type of the given name (PlyType_Invalid for unknown names)
+	*/
+	static PlyType ParseType(const string & name) {
+		static const char * names[] = { "char", "uchar", "short", "ushort", "int", "uint", "float", "double" };
+		static const char * sizedNames[] = { "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64" };
+		for (int t = 0; t < PlyType_Invalid; t++) {
+			if (name == names[t] || name == sizedNames[t])
+				return (PlyType)t;
+		}
+		return PlyType_Invalid;
+	}
+	/*
+	Returns size of a value of the type in bytes
+	*/
+	static uint TypeSize(PlyType type) {
+		static const uint sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+		return sizes[type];
+	}
+	/*
+	Returns binary value of the type stored at p
+
+	swap - bytes of the value are in the reversed order
+	*/
+	static double ReadValue(const char * p, PlyType type, bool swap) {
+		char bytes[8];
+		const uint size = TypeSize(type);
+		for (uint i = 0; i < size; i++) {
+			bytes[i] = p[swap ? size - 1 - i : i];
+		}
+
+		switch (type) {
+		case PlyType_Int8: return (double)*(signed char *)bytes;
+		case PlyType_UInt8: return (double)*(unsigned char *)bytes;
+		case PlyType_Int16: { short v; memcpy(&v, bytes, 2); return (double)v; }
+		case PlyType_UInt16: { unsigned short v; memcpy(&v, bytes, 2); return (double)v; }
+		case PlyType_Int32: { int v; memcpy(&v, bytes, 4); return (double)v; }
+		case PlyType_UInt32: { uint v; memcpy(&v, bytes, 4); return (double)v; }
+		case PlyType_Float32: { float v; memcpy(&v, bytes, 4); return (double)v; }
+		case PlyType_Float64: { double v; memcpy(&v, bytes, 8); return v; }
+		default: return 0.;
+		}
+	}
+};
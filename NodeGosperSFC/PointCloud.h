@@ -28,6 +28,34 @@
 //
 
 #include "common.h"
+#include "MappedFile.h"
+#include "TextParser.h"
+#include "PointFile.h"
+#include "PointStream.h"
+#include "LasFile.h"
+#include "PlyFile.h"
+#include "GzipFile.h"
+#include "Pipeline.h"
+#include "AttributeColumn.h"
+#include "Parallel.h"
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POINTCLOUD_SSE2
+#include <emmintrin.h>
+#endif
+
+//Chunk of a text point file
+struct TextChunk
+{
+	const char * begin, * end; //Text of the chunk
+	size_t first; //Index of the first token of the chunk
+	size_t tokens; //Number of tokens in the chunk
+	BB bb; //BB of parsed values
+	bool valid; //All tokens of the chunk are numbers
+};
 
 /*
 PointCloud class loading / containing data
@@ -40,27 +68,253 @@ private:
 	uint pnum; //Number of points
 	Point * data; //Array of points
 	BB * bb; //Bounding box
+	Point center; //Translation subtracted from the stored points (zero unless attached by AttachArray)
+	MappedFile * mapping; //Mapping of a binary point file used directly as the array of points
+	bool owner; //Array of points is allocated by the object
+	uint capacity; //Number of points the array grown by AppendPoints can hold (0 = exact size)
+
+	/**
+	Releases points and BB
+	*/
+	void Release();
+	/**
+	Enlarges the owned array of points to hold at least num points, the capacity grows geometrically \
+	and the stored points are kept (a mapped or attached array is copied)
+	*/
+	void Reserve(uint num);
+	vector<string> sources; //Files the points were loaded from
+	vector<uint> sourceFirst; //Index of the first point of each source file (and number of loaded points)
+	vector<AttributeColumn> attributes; //Columns of attributes of points
+
+	/**
+	Splits text into chunks at newlines, the chunks are appended
+	*/
+	static void SplitText(const char * text, size_t size, uint threads, vector<TextChunk> & chunks);
+	/**
+	Counts tokens of chunks in parallel and sets indices of their first tokens, returns number of all tokens
+	*/
+	static size_t CountText(vector<TextChunk> & chunks, uint threads);
+	/**
+	Parses counted chunks in parallel into their slots of an array of points, computes BB from BBs of chunks
+
+	pts - array of n points
+	columnNum - number of tokens of a point
+	columns - dimension of each token of a point, -1 for skipped tokens, -2 - a for tokens of the a-th attribute \
+	(NULL = tokens are dimensions in order)
+	attrs - attribute columns written from the index attrFirst
+	*/
+	static bool ParseText(vector<TextChunk> & chunks, Point * pts, uint n, BB & box, uint threads, uint columnNum = D, const int * columns = NULL,
+		AttributeColumn * attrs = NULL, uint attrFirst = 0);
+	/**
+	Loads points of gzip-compressed text (see GzipFile.h). The text is decompressed on a separate thread \
+	and passed in blocks through a bounded queue, whole points of each block are parsed in parallel.
+
+	n - number of points (0 = all points)
+	columnNum, columns - tokens of a point, see ParseText
+	*/
+	bool LoadGzipText(const char * gz, size_t size, uint n, uint threads, uint columnNum, const int * columns);
+	/**
+	Creates attributes of columns of a text file, returns false if the columns do not contain each coordinate once
+
+	columnNum, map - tokens of a point for ParseText (D coordinates in order for no columns)
+	*/
+	bool TextLayout(const vector<TextColumn> & columns, uint & columnNum, vector<int> & map);
+	/**
+	Fills the array of points by decode(i, point) in parallel blocks, computes BB from BBs of blocks
+	*/
+	template <class F> void DecodePoints(F decode, uint threads);
+	/**
+	Returns union of BBs of blocks of points (zero BB for no blocks)
+	*/
+	static BB MergeBB(const vector<BB> & boxes);
+	/**
+	Corrects BB to the square with a small margin, the dataset is not modified. \
+	SFCs derive their frame from the BB and hash the points relative to its center.
+	*/
+	void NormalizeFrame();
 
 public:
 	PointCloud();
 	virtual ~PointCloud();
 	
 	/**
-	Loads point dataset
+	Loads point dataset, gzip-compressed files are decompressed while parsing
+
+	path - file address
+	n - number of points, extra points in the file are ignored \
+	(0 = all points, the number is determined by counting numbers in the file)
+	centering - if true, the BB is normalized to the square frame of the dataset, otherwise it is the exact BB \
+	(points are always kept in original coordinates)
+	threads - number of threads parsing chunks of the file (0 = all hardware threads)
+	*/
+	bool LoadDataset(string path, uint n = 0, bool centering = true, uint threads = 0);
+	/**
+	Loads point dataset with extra columns, e.g. { "x", "y", { "intensity", AttributeType_UInt16 }, "" }. \
+	Columns named by coordinates are read into points, unnamed columns are skipped and the other ones \
+	are read into attribute columns of the given types (see GetAttribute).
+
+	columns - columns of each point of the file
+	*/
+	bool LoadDataset(string path, const vector<TextColumn> & columns, uint n = 0, bool centering = true, uint threads = 0);
+	/**
+	Loads all points of several text point files (shards) into one array. Chunks of all files \
+	are counted and parsed in parallel, the BB is merged from all files before its normalization. \
+	The file of each point is given by GetSource.
+
+	paths - file addresses
+	centering - if true, the BB is normalized to the square frame of the dataset
+	threads - number of threads parsing chunks of the files (0 = all hardware threads)
+	*/
+	bool LoadDatasets(const vector<string> & paths, bool centering = true, uint threads = 0);
+	/**
+	Loads all text point files matching a wildcard pattern (e.g. "data/shard_*.txt") sorted by name, see LoadDatasets
+	*/
+	bool LoadDatasets(string pattern, bool centering = true, uint threads = 0);
+	/**
+	Loads points of a binary LAS file (uncompressed point data record formats 0 - 10). \
+	Coordinates and the requested attributes are read from the records in parallel blocks, other fields are not decoded.
 
 	path - file address
+	centering - if true, the BB is normalized to the square frame of the dataset
+	threads - number of threads reading records (0 = all hardware threads)
+	attributeNames - loaded attributes, any of intensity, return_number, classification \
+	and gps_time (formats with time), e.g. { "intensity", "classification" }
+	*/
+	bool LoadLAS(string path, bool centering = true, uint threads = 0, const vector<string> & attributeNames = vector<string>());
+	/**
+	Loads vertices of a PLY file (ascii or binary). The properties x, y (and z) are read \
+	from the records in parallel chunks.
+
+	path - file address
+	centering - if true, the BB is normalized to the square frame of the dataset
+	threads - number of threads reading records (0 = all hardware threads)
+	attributeNames - scalar properties of vertices loaded as attributes of their types, other properties are skipped
+	*/
+	bool LoadPLY(string path, bool centering = true, uint threads = 0, const vector<string> & attributeNames = vector<string>());
+	/**
+	Appends points to the dataset, the points are translated in the same way as the stored ones \
+	and the bounding box is enlarged to contain them. Attributes of the appended points are zeros.
+
+	pts - array of points
+	m - number of points
+	*/
+	void AppendPoints(const Point * pts, uint m);
+	/**
+	Loads binary point file (see PointFile.h). If the file stores double coordinates of dimension D, \
+	the read-only mapping of the file is used directly as the array of points without copying. \
+	The stored BB is used if present.
+
+	path - file address
+	centering - if true, the BB is normalized to the square frame of the dataset
+	*/
+	bool LoadBinary(string path, bool centering = true);
+	/**
+	Saves points in original coordinates to a binary point file with the BB of points
+
+	path - file address
+	precision - bytes per coordinate: 4 (float) or 8 (double)
+	*/
+	bool SaveBinary(string path, uint precision = 8);
+	/**
+	Converts a text point file to a binary point file
+
+	n - number of points (0 = all points)
+	*/
+	static bool ConvertTextToBinary(string textPath, string binaryPath, uint n = 0, uint precision = 8);
+	/**
+	Saves points in original coordinates to a compressed point stream file (see PointStream.h). \
+	Coordinates are rounded to multiples of quantum, points stored along SFC compress best.
+
+	path - file address
+	quantum - quantization step (max. error of a coordinate is quantum / 2)
+	order - indices of points in the stored order, e.g. SFC indices (NULL = order of the point cloud)
+	blockSize - number of points in an independently decodable block
+	threads - number of threads encoding blocks (0 = all hardware threads)
+	*/
+	bool SaveCompressed(string path, REAL quantum, const uint * order = NULL, uint blockSize = 4096, uint threads = 0);
+	/**
+	Loads compressed point stream file, blocks are decoded in parallel. Points are in the stored order.
+
+	path - file address
+	centering - if true, the BB is normalized to the square frame of the dataset
+	threads - number of threads decoding blocks (0 = all hardware threads)
+	*/
+	bool LoadCompressed(string path, bool centering = true, uint threads = 0);
+	/**
+	Uses an external array of points as the dataset, the array is not released by the object \
+	(appending points copies it)
+
+	pts - array of points
 	n - number of points
+	_bb - bounding box
+	_center - translation subtracted from the points (zero for points in original coordinates)
+	*/
+	void AttachArray(Point * pts, uint n, const BB & _bb, const Point & _center);
+	/**
+	Uses an external array of points in original coordinates as the dataset, the BB is computed \
+	by ComputeBB (the array is not released by the object)
+
+	centering - if true, the BB is normalized to the square frame of the dataset
+	threads - number of threads computing the BB (0 = all hardware threads)
 	*/
-	bool LoadDataset(string path, uint n);
+	void AttachArray(Point * pts, uint n, bool centering = true, uint threads = 0);
+	/**
+	Returns BB of an array of points (zero BB for no points). Blocks of points are reduced \
+	in parallel by SIMD min / max (SSE2), the reduction is bound by the memory bandwidth.
+
+	threads - number of threads (0 = all hardware threads)
+	*/
+	static BB ComputeBB(const Point * pts, uint n, uint threads = 0);
 	/**
 	Returns number of points
 	*/
 	uint GetPointNum() { return pnum; }
 	/**
+	Returns number of files the points were loaded from
+	*/
+	uint GetSourceNum() { return (uint)sources.size(); }
+	/**
+	Returns address of the s-th source file
+	*/
+	const string & GetSourcePath(uint s) { return sources[s]; }
+	/**
+	Returns index of the source file of the i-th point (GetSourceNum() for appended points)
+	*/
+	uint GetSource(uint i) {
+		return (sourceFirst.empty() ? 0 : (uint)(upper_bound(sourceFirst.begin(), sourceFirst.end(), i) - sourceFirst.begin()) - 1);
+	}
+	/**
+	Returns number of attribute columns
+	*/
+	uint GetAttributeNum() { return (uint)attributes.size(); }
+	/**
+	Returns the a-th attribute column
+	*/
+	AttributeColumn & GetAttribute(uint a) { return attributes[a]; }
+	/**
+	Returns index of the attribute of the given name (-1 if there is none)
+	*/
+	int FindAttribute(string name);
+	/**
+	Adds an attribute column of zero values, returns its index
+	*/
+	uint AddAttribute(string name, AttributeType type);
+	/**
+	Copies the attribute columns into the order of points along SFC (called by SFC construction)
+
+	indices - indices of points along SFC (number of points)
+	threads - number of threads (0 = all hardware threads)
+	*/
+	void OrderAttributes(const uint * indices, uint threads = 0);
+	/**
 	Returns bounding box
 	*/
 	const BB * GetBB() { return bb; }
 	/**
+	Returns translation subtracted from the stored points (original coordinates are the stored ones plus the translation)
+	*/
+	const Point & GetCenter() { return center; }
+	/**
 	Returns pointer to the array of points
 	*/
 	const Point * GetArray() { return data; }
@@ -73,58 +327,417 @@ public:
 template <uint D> PointCloud<D>::PointCloud()
 {
 	pnum = 0;
+	capacity = 0;
 	data = NULL;
 	bb = NULL;
+	mapping = NULL;
+	owner = false;
+	for (uint d = 0; d < D; d++) {
+		center.arr[d] = 0.;
+	}
 }
 
 template <uint D> PointCloud<D>::~PointCloud()
+{
+	Release();
+}
+
+template <uint D> void PointCloud<D>::Release()
 {
 	pnum = 0;
-	delete[] data;
+	if (owner)
+		delete[] data;
+	delete mapping;
+	mapping = NULL;
+	owner = false;
+	capacity = 0;
 	data = NULL;
 	delete bb;
 	bb = NULL;
+	for (uint d = 0; d < D; d++) {
+		center.arr[d] = 0.;
+	}
+	sources.clear();
+	sourceFirst.clear();
+	attributes.clear();
 }
 
-template <uint D> bool PointCloud<D>::LoadDataset(const string path, const uint n)
+template <uint D> bool PointCloud<D>::LoadDataset(const string path, const uint n, const bool centering, const uint threads)
 {
-	pnum = n;
-	data = new Point[n];
-	bb = new BB();
+	return LoadDataset(path, vector<TextColumn>(), n, centering, threads);
+}
 
-	ifstream is(path);
+template <uint D> bool PointCloud<D>::LoadDataset(const string path, const vector<TextColumn> & columns, const uint n, const bool centering, const uint threads)
+{
+	Release();
 
-	if (!is.is_open()) {
-		is.close();
+	uint columnNum;
+	vector<int> map;
+	if (!TextLayout(columns, columnNum, map)) {
+		Release();
+		cout << "ERROR: Columns have to contain each of " << D << " coordinates once" << endl;
+		return false;
+	}
+
+	MappedFile file;
+
+	if (!file.Open(path)) {
+		Release();
 		cout << "File " << path << " cannot be opened." << endl;
 		return false;
 	}
 
-	//Load points from file, compute BB
-	Point * p = data;
-	for (uint i = 0; i < n; i++, p++) {
-		for (uint d = 0; d < D; d++) {
-			is >> p->arr[d];
+	if (GzipReader::IsGzip(file.GetData(), file.GetSize())) {
+		if (!LoadGzipText(file.GetData(), file.GetSize(), n, threads, columnNum, &map[0])) {
+			file.Close();
+			Release();
+			cout << "Error while reading file " << path << "." << endl;
+			return false;
 		}
+	}
+	else {
+		//Split file into chunks at newlines and count their numbers
+		vector<TextChunk> chunks;
+		SplitText(file.GetData(), file.GetSize(), threads, chunks);
+		size_t tokenNum = CountText(chunks, threads);
 
-		if (!is.good()) {
-			is.close();
+		//Number of points given by the count of numbers
+		if (n == 0 && (tokenNum % columnNum != 0 || tokenNum / columnNum > 0xFFFFFFFFULL)) {
+			file.Close();
 			cout << "Error while reading file " << path << "." << endl;
 			return false;
 		}
+		pnum = (n == 0 ? (uint)(tokenNum / columnNum) : n);
+		data = new Point[pnum];
+		owner = true;
+		bb = new BB();
+		for (size_t a = 0; a < attributes.size(); a++) {
+			attributes[a].Resize(pnum);
+		}
 
-		if (i == 0) {
-			bb->min = bb->max = *p;
+		//Load points from chunks in parallel, compute BB
+		if (tokenNum < (size_t)pnum * columnNum || !ParseText(chunks, data, pnum, *bb, threads, columnNum, &map[0],
+			attributes.empty() ? NULL : &attributes[0])) {
+			file.Close();
+			cout << "Error while reading file " << path << "." << endl;
+			return false;
 		}
+	}
+
+	file.Close();
+	sources.assign(1, path);
+	sourceFirst.push_back(0);
+	sourceFirst.push_back(pnum);
 
+	if (centering)
+		NormalizeFrame();
+	
+	return true;
+}
+
+template <uint D> bool PointCloud<D>::TextLayout(const vector<TextColumn> & columns, uint & columnNum, vector<int> & map)
+{
+	static const char * coordNames[3] = { "x", "y", "z" };
+	if (columns.empty()) {
+		columnNum = D;
 		for (uint d = 0; d < D; d++) {
-			bb->min.arr[d] = (p->arr[d] < bb->min.arr[d] ? p->arr[d] : bb->min.arr[d]);
-			bb->max.arr[d] = (p->arr[d] > bb->max.arr[d] ? p->arr[d] : bb->max.arr[d]);
+			map.push_back((int)d);
+		}
+		return true;
+	}
+
+	columnNum = (uint)columns.size();
+	uint coordNum = 0;
+	for (uint k = 0; k < columnNum; k++) {
+		int m = -1;
+		for (uint d = 0; d < D && d < 3; d++) {
+			if (columns[k].name == coordNames[d]) {
+				m = (int)d;
+				coordNum++;
+			}
+		}
+		if (m < 0 && !columns[k].name.empty()) {
+			m = -2 - (int)attributes.size();
+			attributes.push_back(AttributeColumn(columns[k].name, columns[k].type));
+		}
+		for (uint j = 0; j < k; j++) {
+			if (m >= 0 && map[j] == m)
+				return false;
+		}
+		map.push_back(m);
+	}
+	return coordNum == D;
+}
+
+template <uint D> bool PointCloud<D>::LoadDatasets(const vector<string> & paths, const bool centering, const uint threads)
+{
+	Release();
+
+	//All files stay mapped until they are parsed
+	const size_t fileNum = paths.size();
+	MappedFile * files = new MappedFile[fileNum];
+	vector<TextChunk> chunks;
+	vector<size_t> fileChunks(fileNum + 1); //Index of the first chunk of each file
+	for (size_t f = 0; f < fileNum; f++) {
+		if (!files[f].Open(paths[f])) {
+			delete[] files;
+			cout << "File " << paths[f] << " cannot be opened." << endl;
+			return false;
+		}
+		fileChunks[f] = chunks.size();
+		SplitText(files[f].GetData(), files[f].GetSize(), threads, chunks);
+	}
+	fileChunks[fileNum] = chunks.size();
+
+	//Chunks of all files counted together, each file has to hold whole points
+	size_t tokenNum = CountText(chunks, threads);
+	sourceFirst.resize(fileNum + 1);
+	for (size_t f = 0; f <= fileNum; f++) {
+		size_t first = (fileChunks[f] < chunks.size() ? chunks[fileChunks[f]].first : tokenNum);
+		size_t last = (f < fileNum && fileChunks[f + 1] < chunks.size() ? chunks[fileChunks[f + 1]].first : tokenNum);
+		if (first / D > 0xFFFFFFFFULL || (f < fileNum && (last - first) % D != 0)) {
+			delete[] files;
+			sourceFirst.clear();
+			cout << "Error while reading file " << paths[f < fileNum ? f : fileNum - 1] << "." << endl;
+			return false;
+		}
+		sourceFirst[f] = (uint)(first / D);
+	}
+
+	pnum = (uint)(tokenNum / D);
+	data = new Point[pnum];
+	owner = true;
+	bb = new BB();
+
+	//Chunks of all files parsed in parallel, BB merged from all chunks
+	if (!ParseText(chunks, data, pnum, *bb, threads)) {
+		size_t c = 0, f = 0;
+		while (chunks[c].valid)
+			c++;
+		while (fileChunks[f + 1] <= c)
+			f++;
+		cout << "Error while reading file " << paths[f] << "." << endl;
+		delete[] files;
+		Release();
+		return false;
+	}
+
+	delete[] files;
+	sources = paths;
+
+	if (centering)
+		NormalizeFrame();
+
+	return true;
+}
+
+template <uint D> bool PointCloud<D>::LoadDatasets(const string pattern, const bool centering, const uint threads)
+{
+	vector<string> paths;
+	if (!ListFiles(pattern, paths) || paths.empty()) {
+		cout << "File " << pattern << " cannot be opened." << endl;
+		return false;
+	}
+	return LoadDatasets(paths, centering, threads);
+}
+
+template <uint D> void PointCloud<D>::SplitText(const char * text, size_t size, uint threads, vector<TextChunk> & chunks)
+{
+	//Chunks of at least 1 MB, several per thread for balancing
+	const size_t minChunkSize = 1 << 20;
+	size_t chunkNum = 4 * (size_t)ThreadNum(threads);
+	if (chunkNum > size / minChunkSize)
+		chunkNum = (size / minChunkSize > 0 ? size / minChunkSize : 1);
+
+	vector<const char *> bounds;
+	TextParser::SplitChunks(text, size, (uint)chunkNum, bounds);
+
+	const size_t offset = chunks.size();
+	chunks.resize(offset + chunkNum);
+	for (size_t c = 0; c < chunkNum; c++) {
+		chunks[offset + c].begin = bounds[c];
+		chunks[offset + c].end = bounds[c + 1];
+	}
+}
+
+template <uint D> size_t PointCloud<D>::CountText(vector<TextChunk> & chunks, uint threads)
+{
+	ParallelFor((uint)chunks.size(), [&](uint c) {
+		chunks[c].tokens = TextParser::CountTokens(chunks[c].begin, chunks[c].end);
+	}, threads);
+
+	//Index of the first token of each chunk
+	size_t first = 0;
+	for (size_t c = 0; c < chunks.size(); c++) {
+		chunks[c].first = first;
+		first += chunks[c].tokens;
+	}
+
+	return first;
+}
+
+template <uint D> bool PointCloud<D>::ParseText(vector<TextChunk> & chunks, Point * pts, const uint n, BB & box, const uint threads, const uint columnNum, const int * columns,
+	AttributeColumn * attrs, const uint attrFirst)
+{
+	const size_t tokenNum = (size_t)n * columnNum;
+	atomic<bool> ok(true);
+
+	ParallelFor((uint)chunks.size(), [&](uint c) {
+		TextChunk & chunk = chunks[c];
+		chunk.valid = true;
+		for (uint d = 0; d < D; d++) {
+			chunk.bb.min.arr[d] = numeric_limits<REAL>::max();
+			chunk.bb.max.arr[d] = -numeric_limits<REAL>::max();
+		}
+
+		//Tokens are written into their slots, extra tokens are ignored
+		const char * it = chunk.begin;
+		size_t last = chunk.first + chunk.tokens;
+		last = (last < tokenNum ? last : tokenNum);
+		REAL v;
+		size_t i = chunk.first / columnNum; //Index of the point
+		uint k = (uint)(chunk.first % columnNum); //Index of the token in the point
+		for (size_t t = chunk.first; t < last; t++) {
+			int d = (columns ? columns[k] : (int)k);
+			if (d == -1 ? !TextParser::SkipToken(it, chunk.end) : !TextParser::ParseReal(it, chunk.end, v)) {
+				chunk.valid = false;
+				ok = false;
+				return;
+			}
+
+			if (d >= 0) {
+				pts[i].arr[d] = v;
+				chunk.bb.min.arr[d] = (v < chunk.bb.min.arr[d] ? v : chunk.bb.min.arr[d]);
+				chunk.bb.max.arr[d] = (v > chunk.bb.max.arr[d] ? v : chunk.bb.max.arr[d]);
+			}
+			else if (d < -1) {
+				attrs[-2 - d].Set(attrFirst + (uint)i, v);
+			}
+			if (++k == columnNum) {
+				k = 0;
+				i++;
+			}
+		}
+	}, threads);
+
+	if (!ok)
+		return false;
+
+	//Merge BBs of chunks
+	for (uint d = 0; d < D; d++) {
+		box.min.arr[d] = (n > 0 ? numeric_limits<REAL>::max() : 0.);
+		box.max.arr[d] = (n > 0 ? -numeric_limits<REAL>::max() : 0.);
+	}
+	for (size_t c = 0; c < chunks.size(); c++) {
+		for (uint d = 0; d < D; d++) {
+			box.min.arr[d] = (chunks[c].bb.min.arr[d] < box.min.arr[d] ? chunks[c].bb.min.arr[d] : box.min.arr[d]);
+			box.max.arr[d] = (chunks[c].bb.max.arr[d] > box.max.arr[d] ? chunks[c].bb.max.arr[d] : box.max.arr[d]);
+		}
+	}
+
+	return true;
+}
+
+template <uint D> bool PointCloud<D>::LoadGzipText(const char * gz, const size_t size, const uint n, const uint threads, const uint columnNum, const int * columns)
+{
+	//Blocks of decompressed text circulate between the threads
+	const size_t blockSize = 1 << 24;
+	const uint depth = 3;
+	vector<vector<char> > blocks(depth);
+	BoundedQueue<vector<char> *> freeBlocks(depth), filled(depth);
+	for (uint b = 0; b < depth; b++) {
+		freeBlocks.Push(&blocks[b]);
+	}
+
+	bool inflated = false;
+	thread producer([&]() {
+		GzipReader reader(gz, size, threads);
+		vector<char> * block = NULL;
+		inflated = freeBlocks.Pop(block) && reader.Decompress([&](const char * text, size_t len) {
+			block->insert(block->end(), text, text + len);
+			return block->size() < blockSize || (filled.Push(block) && freeBlocks.Pop(block));
+		});
+		if (inflated && !block->empty())
+			filled.Push(block);
+		filled.Close();
+	});
+
+	//Points are parsed straight into the array, its capacity grows if the number of points is not given
+	if (n > 0)
+		Reserve(n);
+	vector<BB> boxes; //BBs of parsed blocks
+	vector<char> text; //Received text not parsed yet
+	vector<TextChunk> chunks;
+	bool ok = true;
+	bool last = false; //All text was received
+	while (ok && !last && (n == 0 || pnum < n)) {
+		vector<char> * block;
+		last = !filled.Pop(block);
+		if (!last) {
+			text.insert(text.end(), block->begin(), block->end());
+			block->clear();
+			freeBlocks.Push(block);
 		}
+
+		//Whole lines are parsed, the rest waits for the next block
+		size_t cut = text.size();
+		while (!last && cut > 0 && text[cut - 1] != '\n')
+			cut--;
+		chunks.clear();
+		SplitText(text.empty() ? NULL : &text[0], cut, threads, chunks);
+		size_t tokenNum = CountText(chunks, threads);
+		if (tokenNum % columnNum != 0) {
+			if (last) {
+				ok = false;
+				break;
+			}
+			//A point continuing on the next line waits too
+			for (size_t k = 0; k < tokenNum % columnNum; k++) {
+				while (cut > 0 && TextParser::IsSpace(text[cut - 1]))
+					cut--;
+				while (cut > 0 && !TextParser::IsSpace(text[cut - 1]))
+					cut--;
+			}
+			chunks.clear();
+			SplitText(&text[0], cut, threads, chunks);
+			tokenNum = CountText(chunks, threads);
+		}
+
+		size_t num = tokenNum / columnNum;
+		if (n > 0 && pnum + num > n)
+			num = n - pnum;
+		if (pnum + num > 0xFFFFFFFFULL) {
+			ok = false;
+			break;
+		}
+		if (num > 0) {
+			const uint first = pnum;
+			Reserve((uint)(first + num));
+			boxes.resize(boxes.size() + 1);
+			for (size_t a = 0; a < attributes.size(); a++) {
+				attributes[a].Resize((uint)(first + num));
+			}
+			ok = ParseText(chunks, data + first, (uint)num, boxes.back(), threads, columnNum, columns,
+				attributes.empty() ? NULL : &attributes[0], first);
+			pnum = first + (uint)num;
+		}
+		text.erase(text.begin(), text.begin() + cut);
 	}
 
-	is.close();
+	//The producer is stopped if the text is not needed
+	freeBlocks.Close();
+	filled.Close();
+	producer.join();
+	if (!ok || (last && !inflated) || pnum < n)
+		return false;
 
+	Reserve(pnum);
+	bb = new BB(MergeBB(boxes));
+	return true;
+}
+
+template <uint D> void PointCloud<D>::NormalizeFrame()
+{
 	//Correction of dataset to the square BB
 	REAL maxLength = 0.;
 	for (uint d = 0; d < D; d++) {
@@ -135,26 +748,645 @@ template <uint D> bool PointCloud<D>::LoadDataset(const string path, const uint
 		bb->max.arr[d] = bb->min.arr[d] + maxLength;
 	}
 
-	//Centering of dataset to (0,0)
-	p = data;
-	for (uint i = 0; i < n; i++, p++) {
+	//Small shift of bounds to eliminate rounding errors
+	for (uint d = 0; d < D; d++) {
+		bb->max.arr[d] += 0.001*maxLength;
+		bb->min.arr[d] -= 0.001*maxLength;
+	}
+}
+
+template <uint D> void PointCloud<D>::Reserve(const uint num)
+{
+	if (owner && num <= capacity)
+		return;
+
+	unsigned long long grown = (unsigned long long)pnum + (pnum >> 1);
+	grown = (grown > numeric_limits<uint>::max() ? numeric_limits<uint>::max() : grown);
+	uint newCapacity = (num > grown ? num : (uint)grown);
+	Point * tmp = new Point[newCapacity];
+	for (uint i = 0; i < pnum; i++) {
+		tmp[i] = data[i];
+	}
+	if (owner)
+		delete[] data;
+	delete mapping;
+	mapping = NULL;
+	owner = true;
+	data = tmp;
+	capacity = newCapacity;
+}
+
+template <uint D> void PointCloud<D>::AppendPoints(const Point * pts, const uint m)
+{
+	//Capacity of the array grows geometrically, so a series of appends copies the points amortized once
+	Reserve(pnum + m);
+
+	if (!bb) {
+		bb = new BB();
+		bb->min = bb->max = (m > 0 ? pts[0] : center);
 		for (uint d = 0; d < D; d++) {
-			p->arr[d] -= 0.5f*(bb->max.arr[d] + bb->min.arr[d]);
+			bb->min.arr[d] -= center.arr[d];
+			bb->max.arr[d] -= center.arr[d];
 		}
 	}
 
-	REAL subtract;
+	//Translation of new points, enlargement of BB
+	Point * p = data + pnum;
+	for (uint i = 0; i < m; i++, p++) {
+		for (uint d = 0; d < D; d++) {
+			p->arr[d] = pts[i].arr[d] - center.arr[d];
+			bb->min.arr[d] = (p->arr[d] < bb->min.arr[d] ? p->arr[d] : bb->min.arr[d]);
+			bb->max.arr[d] = (p->arr[d] > bb->max.arr[d] ? p->arr[d] : bb->max.arr[d]);
+		}
+	}
+
+	pnum += m;
+	for (size_t a = 0; a < attributes.size(); a++) {
+		attributes[a].Resize(pnum);
+	}
+}
+
+template <uint D> int PointCloud<D>::FindAttribute(const string name)
+{
+	for (size_t a = 0; a < attributes.size(); a++) {
+		if (attributes[a].GetName() == name)
+			return (int)a;
+	}
+	return -1;
+}
+
+template <uint D> uint PointCloud<D>::AddAttribute(const string name, const AttributeType type)
+{
+	attributes.push_back(AttributeColumn(name, type, pnum));
+	return (uint)attributes.size() - 1;
+}
+
+template <uint D> void PointCloud<D>::OrderAttributes(const uint * indices, const uint threads)
+{
+	for (size_t a = 0; a < attributes.size(); a++) {
+		attributes[a].Order(indices, pnum, threads);
+	}
+}
+
+template <uint D> bool PointCloud<D>::LoadBinary(const string path, const bool centering)
+{
+	Release();
+	mapping = new MappedFile();
+
+	if (!mapping->Open(path)) {
+		delete mapping;
+		mapping = NULL;
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+
+	PointFileHeader header;
+	if (mapping->GetSize() < sizeof(PointFileHeader) ||
+		!((const PointFileHeader *)mapping->GetData())->IsValid(mapping->GetSize()) ||
+		((const PointFileHeader *)mapping->GetData())->dimension != D ||
+		((const PointFileHeader *)mapping->GetData())->count > 0xFFFFFFFFULL) {
+		delete mapping;
+		mapping = NULL;
+		cout << "Error while reading file " << path << "." << endl;
+		return false;
+	}
+	memcpy(&header, mapping->GetData(), sizeof(PointFileHeader));
+	pnum = (uint)header.count;
+	const char * coords = mapping->GetData() + header.dataOffset;
+
+	if (header.precision == sizeof(REAL) && sizeof(Point) == D * sizeof(REAL)) {
+		//Zero-copy: the mapping is the array of points
+		data = (Point *)coords;
+	}
+	else {
+		//Conversion of float coordinates
+		data = new Point[pnum];
+		owner = true;
+		const float * f = (const float *)coords;
+		for (uint i = 0; i < pnum; i++) {
+			for (uint d = 0; d < D; d++) {
+				data[i].arr[d] = (REAL)*(f++);
+			}
+		}
+		delete mapping;
+		mapping = NULL;
+	}
+
+	//BB stored in the file or computed
+	bb = new BB();
+	if (header.flags & POINT_FILE_HAS_BB) {
+		for (uint d = 0; d < D; d++) {
+			bb->min.arr[d] = (REAL)header.bbMin[d];
+			bb->max.arr[d] = (REAL)header.bbMax[d];
+		}
+	}
+	else {
+		*bb = ComputeBB(data, pnum);
+	}
+
+	sources.assign(1, path);
+	sourceFirst.push_back(0);
+	sourceFirst.push_back(pnum);
+
+	if (centering)
+		NormalizeFrame();
+
+	return true;
+}
+
+template <uint D> bool PointCloud<D>::SaveBinary(const string path, const uint precision)
+{
+	if (precision != 4 && precision != 8) {
+		cout << "ERROR: Precision has to be 4 or 8 bytes" << endl;
+		return false;
+	}
+
+	FILE * f = fopen(path.c_str(), "wb");
+	if (!f) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+	setvbuf(f, NULL, _IOFBF, 1 << 22);
+
+	//Header with BB of points in original coordinates
+	PointFileHeader header;
+	header.dimension = D;
+	header.precision = precision;
+	header.count = pnum;
+	header.flags = POINT_FILE_HAS_BB;
+	const BB box = ComputeBB(data, pnum);
 	for (uint d = 0; d < D; d++) {
-		subtract = 0.5f*(bb->max.arr[d] + bb->min.arr[d]);
-		bb->max.arr[d] -= subtract;
-		bb->min.arr[d] -= subtract;
+		header.bbMin[d] = box.min.arr[d] + center.arr[d];
+		header.bbMax[d] = box.max.arr[d] + center.arr[d];
 	}
+	bool ok = (fwrite(&header, sizeof(PointFileHeader), 1, f) == 1);
 
-	//Small shift of bounds to eliminate rounding errors
+	//Coordinates in blocks
+	const uint blockSize = 1 << 16;
+	char * block = new char[(size_t)blockSize * D * precision];
+	for (uint i = 0; ok && i < pnum; i += blockSize) {
+		uint num = (pnum - i < blockSize ? pnum - i : blockSize);
+		for (uint j = 0; j < num; j++) {
+			for (uint d = 0; d < D; d++) {
+				REAL v = data[i + j].arr[d] + center.arr[d];
+				if (precision == 8)
+					((double *)block)[j * D + d] = (double)v;
+				else
+					((float *)block)[j * D + d] = (float)v;
+			}
+		}
+		ok = (fwrite(block, (size_t)num * D * precision, 1, f) == 1);
+	}
+	delete[] block;
+
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		cout << "Error while writing file " << path << "." << endl;
+	return ok;
+}
+
+template <uint D> bool PointCloud<D>::ConvertTextToBinary(const string textPath, const string binaryPath, const uint n, const uint precision)
+{
+	PointCloud<D> pc;
+	return pc.LoadDataset(textPath, n, false) && pc.SaveBinary(binaryPath, precision);
+}
+
+template <uint D> void PointCloud<D>::AttachArray(Point * pts, const uint n, const BB & _bb, const Point & _center)
+{
+	Release();
+	data = pts;
+	pnum = n;
+	bb = new BB(_bb);
+	center = _center;
+}
+
+template <uint D> void PointCloud<D>::AttachArray(Point * pts, const uint n, const bool centering, const uint threads)
+{
+	Point zero;
 	for (uint d = 0; d < D; d++) {
-		bb->max.arr[d] += 0.001*maxLength;
-		bb->min.arr[d] -= 0.001*maxLength;
+		zero.arr[d] = 0.;
 	}
-	
+	AttachArray(pts, n, ComputeBB(pts, n, threads), zero);
+
+	if (centering)
+		NormalizeFrame();
+}
+
+template <uint D> BB PointCloud<D>::ComputeBB(const Point * pts, const uint n, const uint threads)
+{
+	const uint blockSize = 1 << 18;
+	const uint blockNum = (uint)(((unsigned long long)n + blockSize - 1) / blockSize);
+	vector<BB> blockBB(blockNum);
+
+	ParallelFor(blockNum, [&](uint b) {
+		const uint first = b * blockSize;
+		const uint last = (n - first < blockSize ? n : first + blockSize);
+		BB & box = blockBB[b];
+		box.min = box.max = pts[first];
+		uint i = first + 1;
+#ifdef POINTCLOUD_SSE2
+		//A 2D point of doubles fills one SSE2 register, four independent accumulators hide the latency
+		if (D == 2 && sizeof(Point) == 2 * sizeof(double) && sizeof(REAL) == sizeof(double)) {
+			const double * c = (const double *)pts;
+			__m128d mn[4], mx[4];
+			for (int k = 0; k < 4; k++) {
+				mn[k] = mx[k] = _mm_loadu_pd(c + 2 * (size_t)first);
+			}
+			for (; i + 4 <= last; i += 4) {
+				for (int k = 0; k < 4; k++) {
+					const __m128d v = _mm_loadu_pd(c + 2 * (size_t)(i + k));
+					mn[k] = _mm_min_pd(mn[k], v);
+					mx[k] = _mm_max_pd(mx[k], v);
+				}
+			}
+			mn[0] = _mm_min_pd(_mm_min_pd(mn[0], mn[1]), _mm_min_pd(mn[2], mn[3]));
+			mx[0] = _mm_max_pd(_mm_max_pd(mx[0], mx[1]), _mm_max_pd(mx[2], mx[3]));
+			_mm_storeu_pd((double *)box.min.arr, mn[0]);
+			_mm_storeu_pd((double *)box.max.arr, mx[0]);
+		}
+#endif
+		for (; i < last; i++) {
+			for (uint d = 0; d < D; d++) {
+				box.min.arr[d] = (pts[i].arr[d] < box.min.arr[d] ? pts[i].arr[d] : box.min.arr[d]);
+				box.max.arr[d] = (pts[i].arr[d] > box.max.arr[d] ? pts[i].arr[d] : box.max.arr[d]);
+			}
+		}
+	}, threads);
+
+	return MergeBB(blockBB);
+}
+
+template <uint D> bool PointCloud<D>::SaveCompressed(const string path, const REAL quantum, const uint * order, const uint blockSize, const uint threads)
+{
+	if (!(quantum > 0.) || blockSize == 0) {
+		cout << "ERROR: Quantum and size of blocks have to be positive" << endl;
+		return false;
+	}
+
+	//Quantized coordinates relative to the minimum of BB
+	PointStreamHeader header;
+	header.dimension = D;
+	header.blockSize = blockSize;
+	header.count = pnum;
+	header.blockNum = (pnum + (unsigned long long)blockSize - 1) / blockSize;
+	header.quantum = quantum;
+	for (uint d = 0; d < D; d++) {
+		header.origin[d] = (bb ? bb->min.arr[d] : 0.) + center.arr[d];
+		if (bb && (bb->max.arr[d] - bb->min.arr[d]) / quantum > 4e18) {
+			cout << "ERROR: Quantum is too small for the extent of points" << endl;
+			return false;
+		}
+	}
+
+	FILE * f = fopen(path.c_str(), "wb");
+	if (!f) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+	setvbuf(f, NULL, _IOFBF, 1 << 22);
+	bool ok = (fwrite(&header, sizeof(PointStreamHeader), 1, f) == 1);
+
+	//Batches of blocks encoded in parallel and written in order
+	const uint batchNum = 4 * ThreadNum(threads);
+	vector<vector<WORD64> > encoded(batchNum);
+	vector<WORD64> table(1, POINT_STREAM_DATA_OFFSET);
+	for (unsigned long long b = 0; ok && b < header.blockNum; b += batchNum) {
+		const uint num = (uint)(header.blockNum - b < batchNum ? header.blockNum - b : batchNum);
+		ParallelFor(num, [&](uint j) {
+			const uint first = (uint)((b + j) * blockSize);
+			const uint last = (pnum - first < blockSize ? pnum : first + blockSize);
+			vector<Int> q((size_t)(last - first) * D);
+			for (uint i = first; i < last; i++) {
+				const Point & p = data[order ? order[i] : i];
+				for (uint d = 0; d < D; d++) {
+					q[(size_t)(i - first) * D + d] = (Int)llround((p.arr[d] + center.arr[d] - header.origin[d]) / quantum);
+				}
+			}
+			encoded[j].clear();
+			PointStreamCodec::EncodeBlock(&q[0], last - first, D, encoded[j]);
+		}, threads);
+
+		for (uint j = 0; ok && j < num; j++) {
+			ok = (encoded[j].empty() || fwrite(&encoded[j][0], encoded[j].size() * sizeof(WORD64), 1, f) == 1);
+			table.push_back(table.back() + encoded[j].size() * sizeof(WORD64));
+		}
+	}
+
+	//Table of blocks, header with its offset
+	header.tableOffset = table.back();
+	ok = ok && fwrite(&table[0], table.size() * sizeof(WORD64), 1, f) == 1;
+	ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(PointStreamHeader), 1, f) == 1;
+
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		cout << "Error while writing file " << path << "." << endl;
+	return ok;
+}
+
+template <uint D> bool PointCloud<D>::LoadCompressed(const string path, const bool centering, const uint threads)
+{
+	Release();
+
+	MappedFile file;
+	if (!file.Open(path)) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+
+	PointStreamHeader header;
+	bool ok = file.GetSize() >= sizeof(PointStreamHeader);
+	if (ok) {
+		memcpy(&header, file.GetData(), sizeof(PointStreamHeader));
+		ok = header.IsValid(file.GetSize()) && header.dimension == D && header.count <= 0xFFFFFFFFULL;
+	}
+
+	//Blocks have to lie in order between the header and the table
+	const WORD64 * table = (ok ? (const WORD64 *)(file.GetData() + header.tableOffset) : NULL);
+	ok = ok && table[0] == POINT_STREAM_DATA_OFFSET && table[header.blockNum] == header.tableOffset;
+	for (unsigned long long b = 0; ok && b < header.blockNum; b++) {
+		ok = table[b] <= table[b + 1] && table[b + 1] % sizeof(WORD64) == 0;
+	}
+	if (!ok) {
+		cout << "Error while reading file " << path << "." << endl;
+		return false;
+	}
+
+	pnum = (uint)header.count;
+	data = new Point[pnum];
+	owner = true;
+	bb = new BB();
+
+	//Blocks decoded in parallel, BB of each block
+	const uint blockNum = (uint)header.blockNum;
+	vector<BB> blockBB(blockNum);
+	atomic<bool> valid(true);
+	ParallelFor(blockNum, [&](uint b) {
+		const uint first = b * header.blockSize;
+		const uint num = (pnum - first < header.blockSize ? pnum - first : header.blockSize);
+		vector<Int> q((size_t)num * D);
+		if (!PointStreamCodec::DecodeBlock((const WORD64 *)(file.GetData() + table[b]), (size_t)(table[b + 1] - table[b]) * 8, num, D, &q[0])) {
+			valid = false;
+			return;
+		}
+
+		BB & box = blockBB[b];
+		for (uint i = 0; i < num; i++) {
+			Point & p = data[first + i];
+			for (uint d = 0; d < D; d++) {
+				p.arr[d] = header.origin[d] + q[(size_t)i * D + d] * header.quantum;
+				box.min.arr[d] = (i == 0 || p.arr[d] < box.min.arr[d] ? p.arr[d] : box.min.arr[d]);
+				box.max.arr[d] = (i == 0 || p.arr[d] > box.max.arr[d] ? p.arr[d] : box.max.arr[d]);
+			}
+		}
+	}, threads);
+
+	file.Close();
+	if (!valid) {
+		Release();
+		cout << "Error while reading file " << path << "." << endl;
+		return false;
+	}
+
+	*bb = MergeBB(blockBB);
+	sources.assign(1, path);
+	sourceFirst.push_back(0);
+	sourceFirst.push_back(pnum);
+
+	if (centering)
+		NormalizeFrame();
+
+	return true;
+}
+
+template <uint D> template <class F> void PointCloud<D>::DecodePoints(F decode, uint threads)
+{
+	const uint blockSize = 1 << 16;
+	const uint blockNum = (uint)(((unsigned long long)pnum + blockSize - 1) / blockSize);
+	vector<BB> blockBB(blockNum);
+
+	ParallelFor(blockNum, [&](uint b) {
+		const uint first = b * blockSize;
+		const uint last = (pnum - first < blockSize ? pnum : first + blockSize);
+		BB & box = blockBB[b];
+		for (uint i = first; i < last; i++) {
+			Point & p = data[i];
+			decode(i, p);
+			for (uint d = 0; d < D; d++) {
+				box.min.arr[d] = (i == first || p.arr[d] < box.min.arr[d] ? p.arr[d] : box.min.arr[d]);
+				box.max.arr[d] = (i == first || p.arr[d] > box.max.arr[d] ? p.arr[d] : box.max.arr[d]);
+			}
+		}
+	}, threads);
+
+	*bb = MergeBB(blockBB);
+}
+
+template <uint D> BB PointCloud<D>::MergeBB(const vector<BB> & boxes)
+{
+	BB result;
+	for (uint d = 0; d < D; d++) {
+		result.min.arr[d] = (boxes.size() > 0 ? boxes[0].min.arr[d] : 0.);
+		result.max.arr[d] = (boxes.size() > 0 ? boxes[0].max.arr[d] : 0.);
+	}
+	for (size_t b = 1; b < boxes.size(); b++) {
+		for (uint d = 0; d < D; d++) {
+			result.min.arr[d] = (boxes[b].min.arr[d] < result.min.arr[d] ? boxes[b].min.arr[d] : result.min.arr[d]);
+			result.max.arr[d] = (boxes[b].max.arr[d] > result.max.arr[d] ? boxes[b].max.arr[d] : result.max.arr[d]);
+		}
+	}
+	return result;
+}
+
+template <uint D> bool PointCloud<D>::LoadLAS(const string path, const bool centering, const uint threads, const vector<string> & attributeNames)
+{
+	Release();
+
+	MappedFile file;
+	if (!file.Open(path)) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+
+	LasHeader header;
+	if (D > 3 || !header.Read(file.GetData(), file.GetSize()) || header.count > 0xFFFFFFFFULL) {
+		cout << "Error while reading file " << path << "." << endl;
+		return false;
+	}
+
+	//Requested fields of records, formats 6 - 10 have wider flags and classification
+	static const char * fieldNames[4] = { "intensity", "return_number", "classification", "gps_time" };
+	static const AttributeType fieldTypes[4] = { AttributeType_UInt16, AttributeType_UInt8, AttributeType_UInt8, AttributeType_Float64 };
+	const bool extended = (header.format >= 6);
+	const bool time = (header.format != 0 && header.format != 2);
+	int fieldAttribute[4] = { -1, -1, -1, -1 }; //Attribute column of each field (-1 = not loaded)
+	for (size_t a = 0; a < attributeNames.size(); a++) {
+		uint f = 0;
+		while (f < 4 && attributeNames[a] != fieldNames[f])
+			f++;
+		if (f == 4 || (f == 3 && !time) || fieldAttribute[f] >= 0) {
+			cout << "ERROR: Attribute " << attributeNames[a] << " cannot be loaded from file " << path << endl;
+			return false;
+		}
+		fieldAttribute[f] = (int)a;
+	}
+
+	pnum = (uint)header.count;
+	data = new Point[pnum];
+	owner = true;
+	bb = new BB();
+	for (size_t a = 0; a < attributeNames.size(); a++) {
+		uint f = (uint)(find(fieldAttribute, fieldAttribute + 4, (int)a) - fieldAttribute);
+		attributes.push_back(AttributeColumn(attributeNames[a], fieldTypes[f], pnum));
+	}
+	unsigned short * intensity = (fieldAttribute[0] >= 0 ? (unsigned short *)attributes[fieldAttribute[0]].GetData() : NULL);
+	unsigned char * returnNumber = (fieldAttribute[1] >= 0 ? (unsigned char *)attributes[fieldAttribute[1]].GetData() : NULL);
+	unsigned char * classification = (fieldAttribute[2] >= 0 ? (unsigned char *)attributes[fieldAttribute[2]].GetData() : NULL);
+	double * gpsTime = (fieldAttribute[3] >= 0 ? (double *)attributes[fieldAttribute[3]].GetData() : NULL);
+
+	//Scaled integer coordinates at the beginning of records
+	const char * records = file.GetData() + header.pointOffset;
+	DecodePoints([&](uint i, Point & p) {
+		const char * r = records + (size_t)i * header.recordLength;
+		for (uint d = 0; d < D; d++) {
+			p.arr[d] = LasHeader::Get<int>(r, 4 * d) * header.scale[d] + header.offset[d];
+		}
+		if (intensity)
+			intensity[i] = LasHeader::Get<unsigned short>(r, 12);
+		if (returnNumber)
+			returnNumber[i] = (unsigned char)(r[14] & (extended ? 15 : 7));
+		if (classification)
+			classification[i] = (unsigned char)(extended ? r[16] : r[15] & 31);
+		if (gpsTime)
+			gpsTime[i] = LasHeader::Get<double>(r, extended ? 22 : 20);
+	}, threads);
+
+	file.Close();
+	sources.assign(1, path);
+	sourceFirst.push_back(0);
+	sourceFirst.push_back(pnum);
+
+	if (centering)
+		NormalizeFrame();
+
+	return true;
+}
+
+template <uint D> bool PointCloud<D>::LoadPLY(const string path, const bool centering, const uint threads, const vector<string> & attributeNames)
+{
+	Release();
+
+	MappedFile file;
+	if (!file.Open(path)) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+
+	//Vertex element with scalar coordinate properties
+	static const char * coordNames[3] = { "x", "y", "z" };
+	PlyHeader header;
+	int vertex = -1;
+	int props[3] = { -1, -1, -1 };
+	bool ok = D <= 3 && header.Read(file.GetData(), file.GetSize()) && (vertex = header.FindElement("vertex")) >= 0 &&
+		header.elements[vertex].count <= 0xFFFFFFFFULL;
+	for (uint d = 0; ok && d < D; d++) {
+		props[d] = header.elements[vertex].FindProperty(coordNames[d]);
+		ok = props[d] >= 0 && !header.elements[vertex].properties[props[d]].list;
+	}
+	if (!ok) {
+		cout << "Error while reading file " << path << "." << endl;
+		return false;
+	}
+
+	//Requested scalar properties (not coordinates) as attributes of their types
+	vector<int> attrProps;
+	for (size_t a = 0; a < attributeNames.size(); a++) {
+		int k = header.elements[vertex].FindProperty(attributeNames[a]);
+		if (k < 0 || header.elements[vertex].properties[k].list || find(props, props + D, k) != props + D ||
+			find(attrProps.begin(), attrProps.end(), k) != attrProps.end()) {
+			cout << "ERROR: Attribute " << attributeNames[a] << " cannot be loaded from file " << path << endl;
+			return false;
+		}
+		attrProps.push_back(k);
+	}
+
+	const PlyElement & element = header.elements[vertex];
+	pnum = (uint)element.count;
+	data = new Point[pnum];
+	owner = true;
+	bb = new BB();
+
+	for (size_t a = 0; a < attrProps.size(); a++) {
+		const PlyProperty & prop = element.properties[attrProps[a]];
+		attributes.push_back(AttributeColumn(prop.name, (AttributeType)prop.type, pnum));
+	}
+
+	const char * it = file.GetData() + header.dataOffset;
+	const char * end = file.GetData() + file.GetSize();
+	if (header.format == PlyFormat_Ascii) {
+		//Lines of the preceding elements are skipped
+		for (int e = 0; ok && e < vertex; e++) {
+			for (unsigned long long r = 0; ok && r < header.elements[e].count; r++) {
+				const char * nl = (const char *)memchr(it, '\n', (size_t)(end - it));
+				ok = (nl != NULL);
+				it = (ok ? nl + 1 : end);
+			}
+		}
+
+		//Tokens of other properties are skipped, vertices have to have a fixed number of values
+		const uint columnNum = (uint)element.properties.size();
+		vector<int> columns(columnNum, -1);
+		for (uint d = 0; d < D; d++) {
+			columns[props[d]] = (int)d;
+		}
+		for (size_t a = 0; a < attrProps.size(); a++) {
+			columns[attrProps[a]] = -2 - (int)a;
+		}
+		vector<TextChunk> chunks;
+		if (ok) {
+			SplitText(it, (size_t)(end - it), threads, chunks);
+			ok = element.recordSize > 0 && CountText(chunks, threads) >= (size_t)pnum * columnNum &&
+				ParseText(chunks, data, pnum, *bb, threads, columnNum, &columns[0], attributes.empty() ? NULL : &attributes[0]);
+		}
+	}
+	else {
+		//Binary records of the preceding elements have to be of fixed size
+		size_t offset = header.dataOffset;
+		for (int e = 0; ok && e < vertex; e++) {
+			const PlyElement & prev = header.elements[e];
+			ok = prev.recordSize > 0 && prev.count <= (file.GetSize() - offset) / prev.recordSize;
+			offset += (ok ? (size_t)prev.count * prev.recordSize : 0);
+		}
+		ok = ok && element.recordSize > 0 && pnum <= (file.GetSize() - offset) / element.recordSize;
+
+		if (ok) {
+			const char * records = file.GetData() + offset;
+			const bool swap = (header.format == PlyFormat_BinaryBigEndian);
+			DecodePoints([&](uint i, Point & p) {
+				const char * r = records + (size_t)i * element.recordSize;
+				for (uint d = 0; d < D; d++) {
+					const PlyProperty & prop = element.properties[props[d]];
+					p.arr[d] = (REAL)PlyHeader::ReadValue(r + prop.offset, prop.type, swap);
+				}
+				for (size_t a = 0; a < attrProps.size(); a++) {
+					const PlyProperty & prop = element.properties[attrProps[a]];
+					attributes[a].Set(i, PlyHeader::ReadValue(r + prop.offset, prop.type, swap));
+				}
+			}, threads);
+		}
+	}
+
+	file.Close();
+	if (!ok) {
+		Release();
+		cout << "Error while reading file " << path << "." << endl;
+		return false;
+	}
+	sources.assign(1, path);
+	sourceFirst.push_back(0);
+	sourceFirst.push_back(pnum);
+
+	if (centering)
+		NormalizeFrame();
+
 	return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstring>
+#include "common.h"
+
+/*
+Binary point file
+
+The header is followed by the raw coordinates of points stored from the offset dataOffset \
+(little-endian, point by point, dimension values of the given precision).
+*/
+
+#define POINT_FILE_MAGIC "NGPC"
+#define POINT_FILE_VERSION 1
+#define POINT_FILE_DATA_OFFSET 128
+#define POINT_FILE_HAS_BB 1 //Flag of the stored BB
+
+//Header of the binary point file (128 bytes)
+struct PointFileHeader
+{
+	char magic[4]; //POINT_FILE_MAGIC
+	uint version; //POINT_FILE_VERSION
+	uint dimension; //Dimension of points
+	uint precision; //Bytes per coordinate: 4 (float) or 8 (double)
+	unsigned long long count; //Number of points
+	unsigned long long dataOffset; //Offset of coordinates from the beginning of the file
+	uint flags; //POINT_FILE_HAS_BB
+	uint reserved;
+	double bbMin[3]; //BB of points (valid with POINT_FILE_HAS_BB)
+	double bbMax[3];
+	char padding[40];
+
+	PointFileHeader() {
+		memset(this, 0, sizeof(PointFileHeader));
+		memcpy(magic, POINT_FILE_MAGIC, 4);
+		version = POINT_FILE_VERSION;
+		dataOffset = POINT_FILE_DATA_OFFSET;
+	}
+	/*
+	Returns true if the header is valid (the coordinates fit into the file and are aligned for direct use of a mapping)
+	*/
+	bool IsValid(unsigned long long fileSize) const {
+		return memcmp(magic, POINT_FILE_MAGIC, 4) == 0 && version == POINT_FILE_VERSION &&
+			dimension > 0 && dimension <= 3 && (precision == 4 || precision == 8) && dataOffset >= sizeof(PointFileHeader) &&
+			dataOffset % sizeof(REAL) == 0 && dataOffset <= fileSize && count <= (fileSize - dataOffset) / (dimension * precision);
+	}
+};
+
+static_assert(sizeof(PointFileHeader) == POINT_FILE_DATA_OFFSET, "Unexpected size of PointFileHeader");
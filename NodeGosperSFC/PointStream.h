@@ -0,0 +1,190 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstring>
+#include "BitPacking.h"
+
+/*
+Compressed point stream file
+
+Coordinates are quantized to integer multiples of quantum from origin and stored in independent blocks \
+of blockSize points. Each block stores its first point raw and the deltas of consecutive points \
+(zigzag-coded) by Rice codes with a parameter per dimension. Points stored along SFC are close \
+to their predecessors, so the deltas need a few bits only.
+
+The header is followed by the blocks (aligned to 8 bytes) and by the table of blockNum + 1 offsets \
+of blocks from the beginning of the file (the last one is the offset of the table).
+*/
+
+#define POINT_STREAM_MAGIC "NGPS"
+#define POINT_STREAM_VERSION 1
+#define POINT_STREAM_DATA_OFFSET 128
+#define POINT_STREAM_ESCAPE 32 //Rice quotient escaping a raw value
+
+//Header of the compressed point stream file (128 bytes)
+struct PointStreamHeader
+{
+	char magic[4]; //POINT_STREAM_MAGIC
+	uint version; //POINT_STREAM_VERSION
+	uint dimension; //Dimension of points
+	uint blockSize; //Number of points in a block
+	unsigned long long count; //Number of points
+	unsigned long long blockNum; //Number of blocks
+	unsigned long long tableOffset; //Offset of the table of blocks from the beginning of the file
+	double quantum; //Quantization step
+	double origin[3]; //Origin of quantized coordinates
+	char padding[56];
+
+	PointStreamHeader() {
+		memset(this, 0, sizeof(PointStreamHeader));
+		memcpy(magic, POINT_STREAM_MAGIC, 4);
+		version = POINT_STREAM_VERSION;
+	}
+	/*
+	Returns true if the header is valid
+	*/
+	bool IsValid(unsigned long long fileSize) const {
+		return memcmp(magic, POINT_STREAM_MAGIC, 4) == 0 && version == POINT_STREAM_VERSION &&
+			dimension > 0 && dimension <= 3 && blockSize > 0 && quantum > 0. &&
+			blockNum == (count + blockSize - 1) / blockSize && tableOffset >= POINT_STREAM_DATA_OFFSET &&
+			tableOffset % sizeof(WORD64) == 0 && tableOffset <= fileSize && (fileSize - tableOffset) / sizeof(WORD64) == blockNum + 1 &&
+			(fileSize - tableOffset) % sizeof(WORD64) == 0;
+	}
+};
+
+static_assert(sizeof(PointStreamHeader) == POINT_STREAM_DATA_OFFSET, "Unexpected size of PointStreamHeader");
+
+/*
+Encoding and decoding of blocks of quantized points
+*/
+class PointStreamCodec
+{
+private:
+	static inline WORD64 Zigzag(Int v) { return (((WORD64)v) << 1) ^ (WORD64)(v >> 63); }
+	static inline Int Unzigzag(WORD64 v) { return (Int)(v >> 1) ^ -(Int)(v & 1); }
+
+	/*
+	Returns number of bits of Rice codes of the given deltas with parameter k
+	*/
+	static WORD64 RiceCost(const Int * q, uint num, uint dim, uint d, uint k) {
+		WORD64 bits = 0;
+		for (uint i = 1; i < num; i++) {
+			WORD64 quot = Zigzag(q[i * dim + d] - q[(i - 1) * dim + d]) >> k;
+			bits += (quot < POINT_STREAM_ESCAPE ? quot + 1 + k : POINT_STREAM_ESCAPE + 1 + 64);
+		}
+		return bits;
+	}
+
+public:
+	/*
+	Appends encoded block of num quantized points of dimension dim to the words, padded to whole words
+	*/
+	static void EncodeBlock(const Int * q, uint num, uint dim, vector<WORD64> & words) {
+		BitWriter writer(words);
+		for (uint d = 0; d < dim; d++) {
+			writer.Write(Zigzag(q[d]), 64);
+		}
+
+		//Rice parameters around the width of the mean delta
+		uint k[3] = { 0, 0, 0 };
+		for (uint d = 0; d < dim; d++) {
+			WORD64 sum = 0;
+			for (uint i = 1; i < num; i++) {
+				WORD64 v = Zigzag(q[i * dim + d] - q[(i - 1) * dim + d]);
+				sum += (v < (((WORD64)1) << 40) ? v : (((WORD64)1) << 40));
+			}
+			uint guess = (num > 1 ? BitWidth(sum / (num - 1)) : 0);
+			WORD64 best = RiceCost(q, num, dim, d, guess);
+			k[d] = guess;
+			for (uint c = (guess > 2 ? guess - 2 : 0); c <= guess + 1 && c < 64; c++) {
+				WORD64 cost = (c == guess ? best : RiceCost(q, num, dim, d, c));
+				if (cost < best) {
+					best = cost;
+					k[d] = c;
+				}
+			}
+			writer.Write(k[d], 6);
+		}
+
+		for (uint i = 1; i < num; i++) {
+			for (uint d = 0; d < dim; d++) {
+				WORD64 v = Zigzag(q[i * dim + d] - q[(i - 1) * dim + d]);
+				WORD64 quot = v >> k[d];
+				if (quot < POINT_STREAM_ESCAPE) {
+					writer.WriteUnary((uint)quot);
+					writer.Write(v, k[d]);
+				}
+				else {
+					writer.WriteUnary(POINT_STREAM_ESCAPE);
+					writer.Write(v, 64);
+				}
+			}
+		}
+		writer.Flush();
+	}
+	/*
+	Decodes block of num quantized points of dimension dim, returns false if the block is not valid
+
+	words - encoded block
+	bitNum - number of bits of the block
+	*/
+	static bool DecodeBlock(const WORD64 * words, size_t bitNum, uint num, uint dim, Int * q) {
+		BitReader reader(words);
+		if (num == 0)
+			return true;
+		if (bitNum < dim * (64 + 6))
+			return false;
+
+		uint k[3];
+		for (uint d = 0; d < dim; d++) {
+			q[d] = Unzigzag(reader.Read(64));
+		}
+		for (uint d = 0; d < dim; d++) {
+			k[d] = (uint)reader.Read(6);
+		}
+
+		for (uint i = 1; i < num; i++) {
+			for (uint d = 0; d < dim; d++) {
+				//Reading never passes the end of the block by more than two words
+				if (reader.GetPosition() >= bitNum)
+					return false;
+				WORD64 v;
+				uint quot = reader.ReadUnary(POINT_STREAM_ESCAPE);
+				if (quot < POINT_STREAM_ESCAPE)
+					v = (((WORD64)quot) << k[d]) | reader.Read(k[d]);
+				else if (quot == POINT_STREAM_ESCAPE)
+					v = reader.Read(64);
+				else
+					return false;
+				q[i * dim + d] = q[(i - 1) * dim + d] + Unzigzag(v);
+			}
+		}
+		return reader.GetPosition() <= bitNum;
+	}
+};
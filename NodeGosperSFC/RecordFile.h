@@ -0,0 +1,78 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstring>
+#include "common.h"
+
+/*
+File of points ordered along Node-Gosper SFC
+
+The header is followed by records (code, sequence number, point) sorted by codes (and sequence numbers \
+of equal codes) from the offset dataOffset, which is aligned for direct I/O.
+*/
+
+#define RECORD_FILE_MAGIC "NGSR"
+#define RECORD_FILE_VERSION 1
+#define RECORD_FILE_DATA_OFFSET 4096
+#define RECORD_SIZE 32 //Size of a record: code (8 bytes), sequence number (8 bytes), point (2 x 8 bytes)
+
+//Header of the record file (128 bytes, padded by zeros to dataOffset)
+struct RecordFileHeader
+{
+	char magic[4]; //RECORD_FILE_MAGIC
+	uint version; //RECORD_FILE_VERSION
+	uint type; //Type of indexation pattern
+	uint level; //Index of max. level of recursion
+	unsigned long long count; //Number of records
+	unsigned long long dataOffset; //Offset of records from the beginning of the file
+	uint recordSize; //RECORD_SIZE
+	uint reserved;
+	double origin[2]; //Frame of the SFC
+	double radius;
+	double bbMin[2]; //BB of points
+	double bbMax[2];
+	char padding[32];
+
+	RecordFileHeader() {
+		memset(this, 0, sizeof(RecordFileHeader));
+		memcpy(magic, RECORD_FILE_MAGIC, 4);
+		version = RECORD_FILE_VERSION;
+		dataOffset = RECORD_FILE_DATA_OFFSET;
+		recordSize = RECORD_SIZE;
+	}
+	/*
+	Returns true if the header is valid
+	*/
+	bool IsValid(unsigned long long fileSize) const {
+		return memcmp(magic, RECORD_FILE_MAGIC, 4) == 0 && version == RECORD_FILE_VERSION && recordSize == RECORD_SIZE &&
+			dataOffset >= sizeof(RecordFileHeader) && dataOffset <= fileSize && count <= (fileSize - dataOffset) / recordSize;
+	}
+};
+
+static_assert(sizeof(RecordFileHeader) == 128, "Unexpected size of RecordFileHeader");
@@ -29,6 +29,7 @@
 
 #include "PointCloud.h"
 #include "Sorting.h"
+#include "CompressedCodes.h"
 
 /*
 Basic SFC abstract class
@@ -40,8 +41,22 @@ template <uint D> class SFC
 private:
 	uint * indices; //Array of point indices
 	CODE * codes; //Array of point codes
+	uint snum; //Number of points indexed by the arrays
+	bool owner; //Arrays are allocated by the object (false if they are external, e.g. mapped from a file)
+	CompressedCodes * compressed; //Block-compressed codes replacing the array of codes (NULL if not compressed)
+
+	/*
+	Allocates arrays of codes and indices for n points
+	*/
+	void Allocate(uint n);
 protected:
 	PointCloud<D> * pc; //Point cloud object
+
+	/*
+	SFC using external constructed arrays of codes and indices, which are not released by the object. \
+	Codes can be given in the compressed form instead of the array (_codes is NULL then), the SFC releases them.
+	*/
+	SFC(PointCloud<D> * _pc, CODE * _codes, uint * _indices, CompressedCodes * _compressed = NULL);
 public:
 	SFC(PointCloud<D> * _pc);
 	virtual ~SFC();
@@ -51,18 +66,43 @@ public:
 	*/
 	uint GetPointNum() { return pc->GetPointNum(); }
 	/*
+	Returns number of points indexed by the arrays of codes and indices
+	*/
+	uint GetCodeNum() { return snum; }
+	/*
 	Returns array of indices
 	*/
 	uint * GetIndices() { return indices; }
 	/*
-	Returns array of codes
+	Returns array of codes (NULL while the codes are compressed, see GetCode and DecompressCodes)
 	*/
 	CODE * GetCodes() { return codes; }
 	/*
+	Returns code of the i-th point along SFC without decompressing the codes
+	*/
+	CODE GetCode(uint i) { return (compressed ? compressed->Get(i) : codes[i]); }
+	/*
+	Returns compressed codes (NULL if the codes are not compressed)
+	*/
+	const CompressedCodes * GetCompressedCodes() { return compressed; }
+	/*
+	Replaces the array of codes by block-compressed codes (see CompressedCodes.h). \
+	The codes are decompressed again by DecompressCodes, ConstructSFC and UpdateSFC.
+	*/
+	void CompressCodes();
+	/*
+	Replaces compressed codes by the array of codes
+	*/
+	void DecompressCodes();
+	/*
 	Returns bounding box
 	*/
 	const BB * GetBB() { return pc->GetBB(); }
 	/*
+	Returns point cloud object
+	*/
+	PointCloud<D> * GetPointCloud() { return pc; }
+	/*
 	Returns SFC hash code of a point p
 
 	p - point being hashed
@@ -77,10 +117,19 @@ public:
 	*/
 	virtual const Point * GetSFCPoint(uint i) { return (pc->GetArray() + indices[i]); }
 	/*
-	Constructs SFC
+	Returns the a-th attribute of the i-th point along SFC (see PointCloud::GetAttribute)
+	*/
+	double GetSFCAttribute(uint a, uint i) { return pc->GetAttribute(a).GetOrdered(i); }
+	/*
+	Constructs SFC, attribute columns of the point cloud are ordered along SFC
 	*/
 	virtual void ConstructSFC();
 	/*
+	Hashes the points appended to the point cloud after the construction \
+	and merges them into the sorted arrays without rehashing the others, attribute columns are ordered again
+	*/
+	virtual void UpdateSFC();
+	/*
 	Returns number of bits representing a code index on one recursive level
 	*/
 	virtual inline uint GetBitShift() = 0;
@@ -93,17 +142,80 @@ public:
 template <uint D> SFC<D>::SFC(PointCloud<D> * _pc)
 {
 	pc = _pc;
-	indices = new uint[GetPointNum()];
-	codes = new CODE[GetPointNum()];
+	snum = GetPointNum();
+	indices = new uint[snum];
+	codes = new CODE[snum];
+	owner = true;
+	compressed = NULL;
+}
+
+template <uint D> SFC<D>::SFC(PointCloud<D> * _pc, CODE * _codes, uint * _indices, CompressedCodes * _compressed)
+{
+	pc = _pc;
+	snum = GetPointNum();
+	indices = _indices;
+	codes = _codes;
+	owner = false;
+	compressed = _compressed;
 }
 
 template <uint D> SFC<D>::~SFC()
 {
 	pc = NULL;
-	delete[] indices;
+	if (owner) {
+		delete[] indices;
+		delete[] codes;
+	}
 	indices = NULL;
-	delete[] codes;
 	codes = NULL;
+	delete compressed;
+	compressed = NULL;
+}
+
+template <uint D> void SFC<D>::Allocate(uint n)
+{
+	if (owner) {
+		delete[] indices;
+		delete[] codes;
+	}
+	delete compressed;
+	compressed = NULL;
+	snum = n;
+	indices = new uint[n];
+	codes = new CODE[n];
+	owner = true;
+}
+
+template <uint D> void SFC<D>::CompressCodes()
+{
+	if (compressed)
+		return;
+
+	compressed = new CompressedCodes();
+	compressed->Compress(codes, snum);
+	if (owner)
+		delete[] codes;
+	codes = NULL;
+}
+
+template <uint D> void SFC<D>::DecompressCodes()
+{
+	if (!compressed)
+		return;
+
+	CODE * cds = new CODE[snum];
+	compressed->Decode(0, snum, cds);
+	delete compressed;
+	compressed = NULL;
+
+	//External indices are copied, so that both arrays are released by the object
+	if (!owner) {
+		uint * idxs = new uint[snum];
+		memcpy(idxs, indices, snum * sizeof(uint));
+		indices = idxs;
+		owner = true;
+	}
+	codes = cds;
 }
 
 template <uint D> void SFC<D>::SortSFC()
@@ -113,6 +225,9 @@ template <uint D> void SFC<D>::SortSFC()
 
 template <uint D> void SFC<D>::ConstructSFC()
 {
+	if (compressed || snum != GetPointNum())
+		Allocate(GetPointNum());
+
 	const Point * pts = pc->GetArray();
 	CODE * cds = codes;
 	uint * idxs = indices;
@@ -122,4 +237,57 @@ template <uint D> void SFC<D>::ConstructSFC()
 	}
 
 	SortSFC();
+	pc->OrderAttributes(indices);
+}
+
+template <uint D> void SFC<D>::UpdateSFC()
+{
+	const uint n = GetPointNum();
+	if (n <= snum)
+		return;
+	DecompressCodes();
+
+	//Hash and sort the appended points
+	const uint m = n - snum;
+	CODE * newCodes = new CODE[m];
+	uint * newIndices = new uint[m];
+	const Point * pts = pc->GetArray() + snum;
+	for (uint i = 0; i < m; i++, pts++) {
+		newIndices[i] = snum + i;
+		newCodes[i] = HashCode(pts);
+	}
+	Sorting<CODE, uint>::quickSort(newCodes, newIndices, 0, ((int)m) - 1);
+
+	//Enlarge arrays
+	CODE * cds = new CODE[n];
+	uint * idxs = new uint[n];
+	for (uint i = 0; i < snum; i++) {
+		cds[i] = codes[i];
+		idxs[i] = indices[i];
+	}
+	if (owner) {
+		delete[] codes;
+		delete[] indices;
+	}
+	codes = cds;
+	indices = idxs;
+	owner = true;
+
+	//Merge both sorted runs from the back
+	Int i = (Int)snum - 1, j = (Int)m - 1, k = (Int)n - 1;
+	while (j >= 0) {
+		if (i >= 0 && codes[i] > newCodes[j]) {
+			codes[k] = codes[i];
+			indices[k--] = indices[i--];
+		}
+		else {
+			codes[k] = newCodes[j];
+			indices[k--] = newIndices[j--];
+		}
+	}
+
+	snum = n;
+	delete[] newCodes;
+	delete[] newIndices;
+	pc->OrderAttributes(indices);
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+
+#include <cstring>
+#include "common.h"
+
+/*
+File of the constructed SFC written by SFCWriter
+
+The header is padded by zeros to 4096 bytes, the sections follow in this order from offsets \
+aligned to 4096 bytes (little-endian, absent sections have zero offsets):
+- codes: count sorted codes (8 bytes each)
+- indices: count indices of points in the original order (4 bytes each)
+- points: count points along SFC in original coordinates (dimension values of the given precision)
+*/
+
+#define SFC_FILE_MAGIC "NGSO"
+#define SFC_FILE_VERSION 1
+#define SFC_FILE_ALIGNMENT 4096 //Alignment of the sections
+#define SFC_FILE_CODES 1 //Flag of the section of codes
+#define SFC_FILE_INDICES 2 //Flag of the section of indices
+#define SFC_FILE_POINTS 4 //Flag of the section of points
+#define SFC_FILE_ALL (SFC_FILE_CODES | SFC_FILE_INDICES | SFC_FILE_POINTS)
+#define SFC_FILE_ATTRIBUTES 8 //Flag of attribute columns appended to points of the text export
+
+//Header of the SFC file (128 bytes)
+struct SFCFileHeader
+{
+	char magic[4]; //SFC_FILE_MAGIC
+	uint version; //SFC_FILE_VERSION
+	uint dimension; //Dimension of points
+	uint precision; //Bytes per coordinate: 4 (float) or 8 (double)
+	uint sections; //Flags of the stored sections
+	uint reserved;
+	unsigned long long count; //Number of points
+	unsigned long long codesOffset; //Offsets of the sections from the beginning of the file
+	unsigned long long indicesOffset;
+	unsigned long long pointsOffset;
+	double bbMin[3]; //BB of points in original coordinates (valid with SFC_FILE_POINTS)
+	double bbMax[3];
+	char padding[24];
+
+	SFCFileHeader() {
+		memset(this, 0, sizeof(SFCFileHeader));
+		memcpy(magic, SFC_FILE_MAGIC, 4);
+		version = SFC_FILE_VERSION;
+	}
+	/*
+	Computes offsets of the given sections
+	*/
+	void Layout() {
+		unsigned long long sizes[3] = { count * sizeof(CODE), count * sizeof(uint), count * dimension * precision };
+		unsigned long long * offsets[3] = { &codesOffset, &indicesOffset, &pointsOffset };
+		unsigned long long pos = SFC_FILE_ALIGNMENT;
+		for (uint s = 0; s < 3; s++) {
+			*offsets[s] = 0;
+			if (sections & (1 << s)) {
+				*offsets[s] = pos;
+				pos = (pos + sizes[s] + SFC_FILE_ALIGNMENT - 1) / SFC_FILE_ALIGNMENT * SFC_FILE_ALIGNMENT;
+			}
+		}
+	}
+	/*
+	Returns true if the header is valid
+	*/
+	bool IsValid(unsigned long long fileSize) const {
+		if (memcmp(magic, SFC_FILE_MAGIC, 4) != 0 || version != SFC_FILE_VERSION || (sections & ~SFC_FILE_ALL) ||
+			dimension == 0 || dimension > 3 || (precision != 4 && precision != 8) || count > 0xFFFFFFFFULL)
+			return false;
+		unsigned long long sizes[3] = { count * sizeof(CODE), count * sizeof(uint), count * dimension * precision };
+		unsigned long long offsets[3] = { codesOffset, indicesOffset, pointsOffset };
+		for (uint s = 0; s < 3; s++) {
+			if ((sections & (1 << s)) && (offsets[s] < SFC_FILE_ALIGNMENT || offsets[s] > fileSize || sizes[s] > fileSize - offsets[s]))
+				return false;
+		}
+		return true;
+	}
+};
+
+static_assert(sizeof(SFCFileHeader) == 128, "Unexpected size of SFCFileHeader");
@@ -0,0 +1,436 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+
+#include <cstdio>
+#include <cmath>
+#include <thread>
+#include "DirectFile.h"
+#include "SFCFile.h"
+#include "SFC.h"
+#include "Parallel.h"
+
+#define SFC_WRITER_BATCH 65536 //Number of points gathered or formatted in one batch
+#define SFC_WRITER_PART 4096 //Number of points processed by one task of a batch
+
+/*
+Writes decimal digits of v, returns the end of the written text
+*/
+inline char * FormatUInt(char * out, unsigned long long v)
+{
+	char digits[20];
+	uint n = 0;
+	do {
+		digits[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+	while (n > 0)
+		*out++ = digits[--n];
+	return out;
+}
+
+/*
+Writes v in the fixed-point notation with the given number of decimals (0 - 9) rounded to the nearest, \
+returns the end of the written text (at most 32 characters). \
+Values too large for the integer conversion are written by snprintf with the full precision.
+*/
+inline char * FormatFixed(char * out, double v, uint decimals)
+{
+	static const double pow10[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+	const double scaled = fabs(v) * pow10[decimals];
+	if (!(scaled < 9e15))
+		return out + snprintf(out, 32, "%.17g", v);
+
+	unsigned long long m = (unsigned long long)(scaled + 0.5);
+	if (v < 0 && m != 0)
+		*out++ = '-';
+
+	//Digits from the lowest, at least one before the decimal point
+	char digits[24];
+	uint n = 0;
+	do {
+		digits[n++] = (char)('0' + m % 10);
+		m /= 10;
+	} while (m);
+	while (n <= decimals)
+		digits[n++] = '0';
+	while (n > decimals)
+		*out++ = digits[--n];
+	if (decimals > 0) {
+		*out++ = '.';
+		while (n > 0)
+			*out++ = digits[--n];
+	}
+	return out;
+}
+
+/*
+Sequential file writer with write-behind
+
+Data are collected in one of two aligned buffers, while the full one is written by direct I/O \
+on a background thread (see DirectFile.h). The padding of the last block is cut.
+*/
+class WriteBehindFile
+{
+private:
+	DirectFile file; //Written file
+	char * buffers[2]; //Aligned buffers
+	char * buffer; //Buffer being filled
+	size_t bufferSize; //Size of a buffer in bytes
+	size_t filled; //Bytes in the buffer being filled
+	unsigned long long size; //Number of written bytes
+	thread writer; //Thread writing the full buffer
+	bool writeFailed; //Error of the background write
+	bool failed; //Write error occurred
+
+	/*
+	Waits for the background write
+	*/
+	void Wait() {
+		if (writer.joinable()) {
+			writer.join();
+			failed |= writeFailed;
+		}
+	}
+	/*
+	Passes the full buffer to the background write
+	*/
+	void Flush() {
+		Wait();
+		char * full = buffer;
+		const size_t n = filled;
+		writer = thread([this, full, n]() {
+			writeFailed = !file.Write(full, n);
+		});
+		buffer = (buffer == buffers[0] ? buffers[1] : buffers[0]);
+		filled = 0;
+	}
+
+public:
+	WriteBehindFile() : buffer(NULL), bufferSize(0), filled(0), size(0), writeFailed(false), failed(false) {
+		buffers[0] = buffers[1] = NULL;
+	}
+	virtual ~WriteBehindFile() {
+		Wait();
+		FreeAligned(buffers[0]);
+		FreeAligned(buffers[1]);
+	}
+
+	/*
+	Creates the file, returns false on error
+
+	_bufferSize - size of a buffer (rounded up to DIRECT_IO_ALIGNMENT)
+	*/
+	bool Open(string path, size_t _bufferSize = 1 << 23) {
+		bufferSize = (_bufferSize + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+		if (bufferSize == 0)
+			bufferSize = DIRECT_IO_ALIGNMENT;
+		buffers[0] = AllocAligned(bufferSize);
+		buffers[1] = AllocAligned(bufferSize);
+		buffer = buffers[0];
+		return buffers[0] && buffers[1] && file.Open(path, true);
+	}
+	/*
+	Appends n bytes
+	*/
+	inline void Write(const void * data, size_t n) {
+		const char * p = (const char *)data;
+		while (n > 0) {
+			const size_t k = (n < bufferSize - filled ? n : bufferSize - filled);
+			memcpy(buffer + filled, p, k);
+			filled += k;
+			size += k;
+			p += k;
+			n -= k;
+			if (filled == bufferSize)
+				Flush();
+		}
+	}
+	/*
+	Appends zeros up to a multiple of alignment
+	*/
+	void Pad(size_t alignment) {
+		size_t n = (size_t)((alignment - size % alignment) % alignment);
+		while (n > 0) {
+			const size_t k = (n < bufferSize - filled ? n : bufferSize - filled);
+			memset(buffer + filled, 0, k);
+			filled += k;
+			size += k;
+			n -= k;
+			if (filled == bufferSize)
+				Flush();
+		}
+	}
+	/*
+	Writes the rest of data and closes the file, returns false on error
+
+	header - rewritten at the beginning of the file (the first DIRECT_IO_ALIGNMENT bytes are replaced)
+	*/
+	bool Finish(const void * header = NULL, size_t headerSize = 0) {
+		//The last block is padded and the padding is cut
+		const size_t padded = (filled + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+		memset(buffer + filled, 0, padded - filled);
+		Wait();
+		failed |= (padded > 0 && !file.Write(buffer, padded));
+		failed |= !file.Truncate(size);
+
+		if (header && !failed) {
+			memset(buffer, 0, DIRECT_IO_ALIGNMENT);
+			memcpy(buffer, header, headerSize);
+			failed = !file.Seek(0) || !file.Write(buffer, DIRECT_IO_ALIGNMENT);
+		}
+		file.Close();
+		return !failed;
+	}
+	/*
+	Returns number of written bytes
+	*/
+	unsigned long long GetSize() { return size; }
+};
+
+/*
+Output of a constructed SFC
+
+Sorted codes, indices and points along the SFC in original coordinates are written to a binary \
+SFC file (see SFCFile.h) or to a text file with one point per line. Points are gathered and formatted \
+in parallel batches and written by a write-behind file.
+
+D - dimension of points
+*/
+template <uint D> class SFCWriter
+{
+private:
+	SFC<D> * sfc; //Written SFC
+	uint threads; //Number of threads gathering and formatting points
+	size_t bufferSize; //Size of a buffer of the output file
+
+public:
+	/*
+	_sfc - constructed SFC
+	_threads - number of threads (0 = all hardware threads)
+	_bufferSize - size of a buffer of the output file (two buffers are used)
+	*/
+	SFCWriter(SFC<D> * _sfc, uint _threads = 0, size_t _bufferSize = 1 << 23) : sfc(_sfc), threads(_threads), bufferSize(_bufferSize) {}
+
+	/*
+	Writes the SFC to a binary SFC file, returns false on error
+
+	sections - flags of the written sections (SFC_FILE_CODES, SFC_FILE_INDICES, SFC_FILE_POINTS)
+	precision - bytes per coordinate: 4 (float) or 8 (double)
+	*/
+	bool WriteBinary(string path, uint sections = SFC_FILE_ALL, uint precision = 8);
+	/*
+	Writes points along the SFC to a text file, one point per line as whitespace-separated values, \
+	returns false on error
+
+	decimals - number of decimals of coordinates (0 - 9)
+	sections - SFC_FILE_POINTS and optionally SFC_FILE_CODES and SFC_FILE_INDICES prepended to each line \
+	and SFC_FILE_ATTRIBUTES appended to each line (attribute columns ordered along the SFC, integers without decimals)
+	*/
+	bool WriteText(string path, uint decimals = 6, uint sections = SFC_FILE_POINTS);
+};
+
+template <uint D> bool SFCWriter<D>::WriteBinary(const string path, const uint sections, const uint precision)
+{
+	if (precision != 4 && precision != 8) {
+		cout << "ERROR: Precision has to be 4 or 8 bytes" << endl;
+		return false;
+	}
+
+	const uint num = sfc->GetCodeNum();
+	SFCFileHeader header;
+	header.dimension = D;
+	header.precision = precision;
+	header.sections = sections & SFC_FILE_ALL;
+	header.count = num;
+	header.Layout();
+
+	WriteBehindFile file;
+	if (!file.Open(path, bufferSize)) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+	file.Write(&header, sizeof(SFCFileHeader));
+	file.Pad(SFC_FILE_ALIGNMENT);
+
+	vector<char> batch((size_t)SFC_WRITER_BATCH * (D * precision > sizeof(CODE) ? D * precision : sizeof(CODE)));
+
+	//Codes (compressed codes are decoded by batches)
+	if (header.sections & SFC_FILE_CODES) {
+		const CompressedCodes * cc = sfc->GetCompressedCodes();
+		for (uint first = 0; first < num; first += SFC_WRITER_BATCH) {
+			const uint n = (num - first < SFC_WRITER_BATCH ? num - first : SFC_WRITER_BATCH);
+			if (cc) {
+				cc->Decode(first, n, (CODE *)&batch[0]);
+				file.Write(&batch[0], (size_t)n * sizeof(CODE));
+			}
+			else {
+				file.Write(sfc->GetCodes() + first, (size_t)n * sizeof(CODE));
+			}
+		}
+		file.Pad(SFC_FILE_ALIGNMENT);
+	}
+
+	//Indices
+	if (header.sections & SFC_FILE_INDICES) {
+		file.Write(sfc->GetIndices(), (size_t)num * sizeof(uint));
+		file.Pad(SFC_FILE_ALIGNMENT);
+	}
+
+	//Points gathered along SFC in parallel parts with their BB
+	if (header.sections & SFC_FILE_POINTS) {
+		const Point center = sfc->GetPointCloud()->GetCenter();
+		const uint partNum = SFC_WRITER_BATCH / SFC_WRITER_PART;
+		vector<BB> partBB(partNum);
+		for (uint first = 0; first < num; first += SFC_WRITER_BATCH) {
+			const uint n = (num - first < SFC_WRITER_BATCH ? num - first : SFC_WRITER_BATCH);
+			const uint parts = (n + SFC_WRITER_PART - 1) / SFC_WRITER_PART;
+			ParallelFor(parts, [&](uint t) {
+				const uint last = (n - t * SFC_WRITER_PART < SFC_WRITER_PART ? n : (t + 1) * SFC_WRITER_PART);
+				BB & b = partBB[t];
+				for (uint i = t * SFC_WRITER_PART; i < last; i++) {
+					const Point * p = sfc->GetSFCPoint(first + i);
+					for (uint d = 0; d < D; d++) {
+						REAL v = p->arr[d] + center.arr[d];
+						if (precision == 8)
+							((double *)&batch[0])[(size_t)i * D + d] = (double)v;
+						else
+							v = ((float *)&batch[0])[(size_t)i * D + d] = (float)v;
+						if (i == t * SFC_WRITER_PART || v < b.min.arr[d])
+							b.min.arr[d] = v;
+						if (i == t * SFC_WRITER_PART || v > b.max.arr[d])
+							b.max.arr[d] = v;
+					}
+				}
+			}, threads);
+			file.Write(&batch[0], (size_t)n * D * precision);
+
+			for (uint t = 0; t < parts; t++) {
+				for (uint d = 0; d < D; d++) {
+					if (first == 0 && t == 0) {
+						header.bbMin[d] = partBB[t].min.arr[d];
+						header.bbMax[d] = partBB[t].max.arr[d];
+					}
+					header.bbMin[d] = (partBB[t].min.arr[d] < header.bbMin[d] ? partBB[t].min.arr[d] : header.bbMin[d]);
+					header.bbMax[d] = (partBB[t].max.arr[d] > header.bbMax[d] ? partBB[t].max.arr[d] : header.bbMax[d]);
+				}
+			}
+		}
+	}
+
+	if (!file.Finish(&header, sizeof(SFCFileHeader))) {
+		cout << "Error while writing file " << path << "." << endl;
+		return false;
+	}
+	return true;
+}
+
+template <uint D> bool SFCWriter<D>::WriteText(const string path, const uint decimals, const uint sections)
+{
+	if (decimals > 9) {
+		cout << "ERROR: Number of decimals has to be at most 9" << endl;
+		return false;
+	}
+
+	//Attribute columns in the order along SFC
+	vector<const AttributeColumn *> attrs;
+	for (uint a = 0; (sections & SFC_FILE_ATTRIBUTES) && a < sfc->GetPointCloud()->GetAttributeNum(); a++) {
+		attrs.push_back(&sfc->GetPointCloud()->GetAttribute(a));
+		if (!attrs.back()->IsOrdered()) {
+			cout << "ERROR: Attributes have to be ordered along SFC" << endl;
+			return false;
+		}
+	}
+
+	WriteBehindFile file;
+	if (!file.Open(path, bufferSize)) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+
+	//Parts of a batch formatted in parallel to their own buffers and written in order
+	const uint num = sfc->GetCodeNum();
+	const bool writeCodes = (sections & SFC_FILE_CODES) != 0;
+	const CODE * codes = sfc->GetCodes();
+	const CompressedCodes * cc = sfc->GetCompressedCodes();
+	vector<CODE> decoded(writeCodes && cc ? SFC_WRITER_BATCH : 0);
+	const uint * indices = sfc->GetIndices();
+	const Point center = sfc->GetPointCloud()->GetCenter();
+	const uint attrNum = (uint)attrs.size();
+	const size_t lineSize = 20 + 1 + 10 + 1 + (D + attrNum) * 33 + 1; //Code, index, coordinates, attributes, separators
+	const uint partNum = SFC_WRITER_BATCH / SFC_WRITER_PART;
+	vector<vector<char> > text(partNum, vector<char>(SFC_WRITER_PART * lineSize));
+	vector<size_t> textSize(partNum);
+	for (uint first = 0; first < num; first += SFC_WRITER_BATCH) {
+		const uint n = (num - first < SFC_WRITER_BATCH ? num - first : SFC_WRITER_BATCH);
+		const uint parts = (n + SFC_WRITER_PART - 1) / SFC_WRITER_PART;
+
+		//Compressed codes are decoded by batches
+		const CODE * batchCodes = (codes ? codes + first : decoded.data());
+		if (writeCodes && cc)
+			cc->Decode(first, n, decoded.data());
+
+		ParallelFor(parts, [&](uint t) {
+			const uint last = (n - t * SFC_WRITER_PART < SFC_WRITER_PART ? n : (t + 1) * SFC_WRITER_PART);
+			char * out = &text[t][0];
+			for (uint i = first + t * SFC_WRITER_PART; i < first + last; i++) {
+				if (writeCodes) {
+					out = FormatUInt(out, batchCodes[i - first]);
+					*out++ = ' ';
+				}
+				if (sections & SFC_FILE_INDICES) {
+					out = FormatUInt(out, indices[i]);
+					*out++ = ' ';
+				}
+				const Point * p = sfc->GetSFCPoint(i);
+				for (uint d = 0; d < D; d++) {
+					out = FormatFixed(out, p->arr[d] + center.arr[d], decimals);
+					*out++ = (d + 1 < D || attrNum > 0 ? ' ' : '\n');
+				}
+				for (uint a = 0; a < attrNum; a++) {
+					const bool real = (attrs[a]->GetType() >= AttributeType_Float32);
+					out = FormatFixed(out, attrs[a]->GetOrdered(i), real ? decimals : 0);
+					*out++ = (a + 1 < attrNum ? ' ' : '\n');
+				}
+			}
+			textSize[t] = (size_t)(out - &text[t][0]);
+		}, threads);
+
+		for (uint t = 0; t < parts; t++) {
+			file.Write(&text[t][0], textSize[t]);
+		}
+	}
+
+	if (!file.Finish()) {
+		cout << "Error while writing file " << path << "." << endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstring>
+#include <vector>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <cerrno>
+#endif
+#include "NodeGosperSFC.h"
+#include "Pipeline.h"
+
+//Record of a streamed point
+struct StreamRecord
+{
+	CODE code; //Node-Gosper code of the point
+	unsigned long long seq; //Sequence number of the point in the stream
+	Point point; //Point in original coordinates
+};
+
+/*
+Streaming Node-Gosper encoder of unbounded point input
+
+Points (whitespace-separated coordinates) are read from a file descriptor or a pipe in blocks, \
+hashed in the fixed frame and passed to the caller in blocks of records. No BB of the data is needed.
+
+Reading with parsing, hashing and passing to the caller run as a pipeline on their own threads, \
+so parsing of a block overlaps hashing of the previous one and output of the earlier ones. \
+Memory is bounded by the input buffer and the depth of the pipeline (number of circulating blocks).
+*/
+class StreamEncoder
+{
+private:
+	PointCloud<2> cloud; //Empty point cloud of the hashing SFC
+	NodeGosperSFC sfc; //SFC of the fixed frame used as the hasher
+	Point origin; //Origin of the frame
+	REAL radius; //Radius covered by the frame
+	uint blockSize; //Number of records passed at once
+	size_t bufferSize; //Size of the input buffer in bytes
+	uint threads; //Number of threads hashing records
+	uint depth; //Number of blocks of records in the pipeline
+	unsigned long long pointNum; //Number of encoded points
+	unsigned long long skipNum; //Number of leading points which are parsed only
+	unsigned long long outsideNum; //Number of encoded points outside the frame
+
+	/*
+	Reads up to size bytes from the file descriptor, returns number of read bytes (0 at the end, -1 on error)
+	*/
+	static long long ReadBlock(int fd, char * buffer, size_t size);
+	/*
+	Parsing stage: reads points into free blocks of records and passes full blocks on, \
+	returns false on a read error or invalid input
+	*/
+	bool Parse(int fd, BoundedQueue<vector<StreamRecord> *> & freeBlocks, BoundedQueue<vector<StreamRecord> *> & parsed);
+	/*
+	Hashing stage: hashes the records in parallel
+	*/
+	void HashBlock(vector<StreamRecord> & records);
+
+public:
+	/*
+	_level - index of max. level of recursion
+	_type - type of indexation pattern
+	frame - origin of the root Gosper island and radius of the circle which has to fit into it
+	_blockSize - number of records passed to the caller at once
+	_bufferSize - size of the input buffer in bytes (limits the length of a number)
+	_threads - number of threads hashing records (0 = all hardware threads)
+	_depth - number of blocks of records in the pipeline
+	*/
+	StreamEncoder(uint _level, NodeGosperSFC_Type _type, const Frame & frame, uint _blockSize = 65536, size_t _bufferSize = 1 << 20,
+		uint _threads = 0, uint _depth = 4) : sfc(_level, &cloud, _type, frame) {
+		origin = frame.origin;
+		radius = sfc.GetFrameRadius();
+		blockSize = (_blockSize > 0 ? _blockSize : 1);
+		bufferSize = (_bufferSize > 64 ? _bufferSize : 64);
+		threads = _threads;
+		depth = (_depth > 0 ? _depth : 1);
+		pointNum = 0;
+		skipNum = 0;
+		outsideNum = 0;
+	}
+	/*
+	Reads points from the file descriptor until the end of input and encodes them. \
+	Records are passed by emit(const StreamRecord * records, uint num) in the order of input \
+	on the calling thread. \
+	Returns false on a read error or invalid input.
+
+	skip - number of leading points which are parsed but not encoded (e.g. input of a resumed build), \
+	sequence numbers of the encoded points continue behind them
+	*/
+	template <class F> bool Encode(int fd, F emit, unsigned long long skip = 0);
+	/*
+	Returns number of points read by the last call of Encode (including the skipped ones)
+	*/
+	unsigned long long GetPointNum() { return pointNum; }
+	/*
+	Returns number of encoded points outside the radius of the frame (their codes are not reliable)
+	*/
+	unsigned long long GetOutsideNum() { return outsideNum; }
+	/*
+	Returns SFC used as the hasher
+	*/
+	NodeGosperSFC & GetSFC() { return sfc; }
+};
+
+long long StreamEncoder::ReadBlock(int fd, char * buffer, size_t size)
+{
+#ifdef _WIN32
+	return _read(fd, buffer, (unsigned int)(size < (1U << 30) ? size : (1U << 30)));
+#else
+	while (true) {
+		ssize_t r = read(fd, buffer, size);
+		if (r >= 0 || errno != EINTR)
+			return (long long)r;
+	}
+#endif
+}
+
+void StreamEncoder::HashBlock(vector<StreamRecord> & records)
+{
+	//Records hashed in parallel parts
+	const uint partSize = 4096;
+	const uint num = (uint)records.size();
+	const uint partNum = (num + partSize - 1) / partSize;
+	vector<uint> outside(partNum, 0);
+	ParallelFor(partNum, [&](uint t) {
+		const uint last = (num - t * partSize < partSize ? num : (t + 1) * partSize);
+		for (uint i = t * partSize; i < last; i++) {
+			StreamRecord & r = records[i];
+			r.code = sfc.HashCode(&r.point);
+			outside[t] += (distance(r.point, origin) > radius);
+		}
+	}, threads);
+
+	for (uint t = 0; t < partNum; t++) {
+		outsideNum += outside[t];
+	}
+}
+
+bool StreamEncoder::Parse(int fd, BoundedQueue<vector<StreamRecord> *> & freeBlocks, BoundedQueue<vector<StreamRecord> *> & parsed)
+{
+	vector<char> buffer(bufferSize);
+	size_t filled = 0; //Bytes in the buffer
+	vector<StreamRecord> * records = NULL;
+	if (!freeBlocks.Pop(records))
+		return false;
+	REAL coords[2];
+	uint k = 0; //Number of read coordinates of the current point
+	bool eof = false;
+
+	while (!eof) {
+		long long r = ReadBlock(fd, &buffer[filled], bufferSize - filled);
+		if (r < 0) {
+			cout << "Error while reading stream." << endl;
+			return false;
+		}
+		eof = (r == 0);
+		filled += (size_t)r;
+
+		//Numbers ending by whitespace are complete, the last one may continue in the next block
+		size_t parsedSize = filled;
+		if (!eof) {
+			while (parsedSize > 0 && !TextParser::IsSpace(buffer[parsedSize - 1]))
+				parsedSize--;
+			if (parsedSize == 0 && filled == bufferSize) {
+				cout << "Error while reading stream." << endl;
+				return false;
+			}
+		}
+
+		const char * it = &buffer[0];
+		const char * end = it + parsedSize;
+		REAL v;
+		while (TextParser::SkipSpaces(it, end)) {
+			if (!TextParser::ParseReal(it, end, v)) {
+				cout << "Error while reading stream." << endl;
+				return false;
+			}
+			coords[k++] = v;
+			if (k == 2) {
+				k = 0;
+				if (pointNum < skipNum) {
+					pointNum++;
+					continue;
+				}
+				StreamRecord rec;
+				rec.code = 0;
+				rec.seq = pointNum++;
+				rec.point = Point(coords[0], coords[1]);
+				records->push_back(rec);
+				if (records->size() == blockSize && (!parsed.Push(records) || !freeBlocks.Pop(records)))
+					return false;
+			}
+		}
+
+		memmove(&buffer[0], &buffer[parsedSize], filled - parsedSize);
+		filled -= parsedSize;
+	}
+
+	if (!records->empty() && !parsed.Push(records))
+		return false;
+
+	//The last point has to be complete
+	if (k != 0) {
+		cout << "Error while reading stream." << endl;
+		return false;
+	}
+	return true;
+}
+
+template <class F> bool StreamEncoder::Encode(int fd, F emit, unsigned long long skip)
+{
+	pointNum = 0;
+	skipNum = skip;
+	outsideNum = 0;
+
+	//Blocks of records circulate among the stages
+	vector<vector<StreamRecord> > blocks(depth);
+	BoundedQueue<vector<StreamRecord> *> freeBlocks(depth), parsed(depth), hashed(depth);
+	for (uint b = 0; b < depth; b++) {
+		blocks[b].reserve(blockSize);
+		freeBlocks.Push(&blocks[b]);
+	}
+
+	bool parseOk = true;
+	thread parser([&]() {
+		parseOk = Parse(fd, freeBlocks, parsed);
+		parsed.Close();
+	});
+	thread hasher([&]() {
+		vector<StreamRecord> * block;
+		while (parsed.Pop(block)) {
+			HashBlock(*block);
+			hashed.Push(block);
+		}
+		hashed.Close();
+	});
+
+	//Output stage on the calling thread
+	vector<StreamRecord> * block;
+	while (hashed.Pop(block)) {
+		emit((const StreamRecord *)&(*block)[0], (uint)block->size());
+		block->clear();
+		freeBlocks.Push(block);
+	}
+
+	parser.join();
+	hasher.join();
+	return parseOk;
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+#include <cstdlib>
+#include <vector>
+#include "common.h"
+
+/*
+Parser of whitespace-separated decimal numbers without stream state and locale
+
+The common numbers (at most 19 significant digits, mantissa up to 2^53 and decimal exponent up to 22) \
+are converted exactly by one multiplication or division, the rest falls back to strtod.
+*/
+class TextParser
+{
+public:
+	/*
+	Returns true for whitespace characters separating numbers
+	*/
+	static inline bool IsSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f'; }
+	/*
+	Skips whitespace, returns false at the end of the buffer
+	*/
+	static inline bool SkipSpaces(const char *& it, const char * end);
+	/*
+	Parses the next number and moves the iterator behind it, returns false if no number follows \
+	or the token is not a valid decimal number
+
+	it - iterator in the buffer
+	end - end of the buffer
+	v - parsed value
+	*/
+	static inline bool ParseReal(const char *& it, const char * end, REAL & v);
+	/*
+	Moves the iterator behind the next token, returns false if no token follows
+	*/
+	static inline bool SkipToken(const char *& it, const char * end);
+	/*
+	Returns number of whitespace-separated tokens in the buffer
+	*/
+	static inline size_t CountTokens(const char * it, const char * end);
+	/*
+	Splits the buffer into chunks at newline boundaries
+
+	bounds - chunkNum + 1 pointers delimiting the chunks (chunks may be empty)
+	*/
+	static inline void SplitChunks(const char * data, size_t size, uint chunkNum, vector<const char *> & bounds);
+};
+
+inline bool TextParser::SkipSpaces(const char *& it, const char * end)
+{
+	while (it < end && IsSpace(*it))
+		it++;
+	return it < end;
+}
+
+inline bool TextParser::ParseReal(const char *& it, const char * end, REAL & v)
+{
+	//Exactly representable powers of 10
+	static const double pow10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	if (!SkipSpaces(it, end))
+		return false;
+
+	const char * token = it;
+	const char * p = it;
+	bool negative = false;
+	if (*p == '-' || *p == '+') {
+		negative = (*p == '-');
+		p++;
+	}
+
+	unsigned long long mantissa = 0; //Significant digits
+	int digits = 0; //Number of significant digits
+	int exp10 = 0; //Decimal exponent
+	bool truncated = false; //Digits beyond 19 significant ones were dropped
+	bool any = false; //At least one digit
+
+	//Integer part
+	for (; p < end && *p >= '0' && *p <= '9'; p++) {
+		any = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += (mantissa != 0);
+		}
+		else {
+			exp10++;
+			truncated |= (*p != '0');
+		}
+	}
+	//Fraction part
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+			any = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += (mantissa != 0);
+				exp10--;
+			}
+			else {
+				truncated |= (*p != '0');
+			}
+		}
+	}
+	if (!any)
+		return false;
+
+	//Exponent
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		bool expNegative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			expNegative = (*p == '-');
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9')
+			return false;
+		int e = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			if (e < 100000)
+				e = e * 10 + (*p - '0');
+		}
+		exp10 += (expNegative ? -e : e);
+	}
+
+	//The token has to end by whitespace
+	if (p < end && !IsSpace(*p))
+		return false;
+	it = p;
+
+	if (!truncated && mantissa <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+		double d = (double)mantissa;
+		d = (exp10 < 0 ? d / pow10[-exp10] : d * pow10[exp10]);
+		v = (REAL)(negative ? -d : d);
+		return true;
+	}
+
+	//Slow path for long or extreme numbers
+	char buffer[128];
+	size_t len = (size_t)(p - token);
+	if (len >= sizeof(buffer)) {
+		v = (REAL)strtod(string(token, len).c_str(), NULL);
+		return true;
+	}
+	for (size_t i = 0; i < len; i++)
+		buffer[i] = token[i];
+	buffer[len] = 0;
+	v = (REAL)strtod(buffer, NULL);
+	return true;
+}
+
+inline bool TextParser::SkipToken(const char *& it, const char * end)
+{
+	if (!SkipSpaces(it, end))
+		return false;
+	while (it < end && !IsSpace(*it))
+		it++;
+	return true;
+}
+
+inline size_t TextParser::CountTokens(const char * it, const char * end)
+{
+	//Table of whitespace characters for a branch-free scan
+	static const struct SpaceTable {
+		unsigned char arr[256];
+		SpaceTable() {
+			for (int c = 0; c < 256; c++)
+				arr[c] = IsSpace((char)c);
+		}
+	} table;
+
+	size_t count = 0;
+	unsigned char space = 1;
+	for (; it < end; it++) {
+		unsigned char s = table.arr[(unsigned char)*it];
+		count += (space & (s ^ 1));
+		space = s;
+	}
+	return count;
+}
+
+inline void TextParser::SplitChunks(const char * data, size_t size, uint chunkNum, vector<const char *> & bounds)
+{
+	const char * end = data + size;
+	bounds.assign(chunkNum + 1, end);
+	bounds[0] = data;
+
+	for (uint c = 1; c < chunkNum; c++) {
+		const char * it = data + (size / chunkNum) * c;
+		if (it < bounds[c - 1])
+			it = bounds[c - 1];
+		while (it < end && *it != '\n')
+			it++;
+		bounds[c] = (it < end ? it + 1 : end);
+	}
+}
\ No newline at end of file
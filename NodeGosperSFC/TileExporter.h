@@ -0,0 +1,318 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+
+#include <cstdio>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include "NodeGosperSFC.h"
+#include "TileFile.h"
+#include "Parallel.h"
+
+/*
+Export of a pyramid of hexagon tiles
+
+Cells of all levels with the numbers of their points (and optional aggregates) are computed \
+in one pass over the sorted codes. Tiles of fine levels are grouped into files by the cell \
+of a coarse prefix level (files are named by the digits of the prefix, e.g. "0312.ngt"), \
+the groups are computed and written in parallel. Tiles of levels above the prefix level \
+are merged from the groups into the file "root.ngt". See TileFile.h for the layout.
+*/
+class TileExporter
+{
+private:
+	NodeGosperSFC * sfc; //Exported SFC
+	uint threads; //Number of threads computing and writing groups
+	uint fileNum; //Number of written files
+
+	//Aggregates of an open tile
+	struct TileSum
+	{
+		unsigned long long count; //Number of points
+		REAL sum[2]; //Sum of points relative to the origin of the SFC
+		REAL valueSum, valueMin, valueMax; //Aggregates of values
+
+		void Reset() {
+			count = 0;
+			sum[0] = sum[1] = 0.;
+			valueSum = 0.;
+			valueMin = numeric_limits<REAL>::max();
+			valueMax = -numeric_limits<REAL>::max();
+		}
+		void Merge(const TileSum & t) {
+			count += t.count;
+			sum[0] += t.sum[0];
+			sum[1] += t.sum[1];
+			valueSum += t.valueSum;
+			valueMin = (t.valueMin < valueMin ? t.valueMin : valueMin);
+			valueMax = (t.valueMax > valueMax ? t.valueMax : valueMax);
+		}
+	};
+
+	/*
+	Appends a tile record to the tiles of a level
+	*/
+	void AppendTile(vector<char> & tiles, CODE code, const TileSum & t, uint flags);
+	/*
+	Writes a tile file, returns false on error
+
+	levels - records of tiles of the levels from header.firstLevel
+	*/
+	bool WriteFile(string path, TileFileHeader & header, const vector<vector<char> > & levels);
+	/*
+	Exports tiles with values aggregated from values in the original order or from an attribute column \
+	ordered along the SFC, see Export
+	*/
+	bool ExportTiles(string dir, uint prefixLevel, uint maxLevel, uint flags, const REAL * values, const AttributeColumn * column);
+
+public:
+	/*
+	_threads - number of threads (0 = all hardware threads)
+	*/
+	TileExporter(NodeGosperSFC * _sfc, uint _threads = 0) : sfc(_sfc), threads(_threads), fileNum(0) {}
+
+	/*
+	Exports tiles of levels 0 - maxLevel to a directory, returns false on error
+
+	dir - existing output directory
+	prefixLevel - tiles of levels prefixLevel - maxLevel are grouped into files by their cell of prefixLevel, \
+	the coarser levels are stored in the root file
+	maxLevel - the deepest exported level (at most the level of the SFC)
+	flags - TILE_FILE_CENTROIDS, TILE_FILE_VALUES
+	values - values of points in the original order aggregated with TILE_FILE_VALUES
+	*/
+	bool Export(string dir, uint prefixLevel, uint maxLevel, uint flags = 0, const REAL * values = NULL);
+	/*
+	Exports tiles with aggregates of an attribute column of the point cloud (ordered along the SFC), \
+	returns false on error. See Export, TILE_FILE_VALUES is always set.
+
+	attribute - index of the attribute (see PointCloud::GetAttribute)
+	*/
+	bool ExportAttribute(string dir, uint prefixLevel, uint maxLevel, uint attribute, uint flags = 0);
+	/*
+	Returns number of files written by the last export
+	*/
+	uint GetFileNum() { return fileNum; }
+};
+
+inline void TileExporter::AppendTile(vector<char> & tiles, const CODE code, const TileSum & t, const uint flags)
+{
+	double record[7];
+	uint k = 0;
+	memcpy(&record[k++], &code, 8);
+	memcpy(&record[k++], &t.count, 8);
+	if (flags & TILE_FILE_CENTROIDS) {
+		const Point origin = sfc->GetFrame().origin;
+		record[k++] = t.sum[0] / t.count + origin.x;
+		record[k++] = t.sum[1] / t.count + origin.y;
+	}
+	if (flags & TILE_FILE_VALUES) {
+		record[k++] = t.valueSum;
+		record[k++] = t.valueMin;
+		record[k++] = t.valueMax;
+	}
+	tiles.insert(tiles.end(), (const char *)record, (const char *)(record + k));
+}
+
+inline bool TileExporter::WriteFile(const string path, TileFileHeader & header, const vector<vector<char> > & levels)
+{
+	FILE * f = fopen(path.c_str(), "wb");
+	if (!f) {
+		cout << "File " << path << " cannot be opened." << endl;
+		return false;
+	}
+
+	//Table of levels
+	vector<unsigned long long> table(2 * levels.size());
+	unsigned long long offset = sizeof(TileFileHeader) + table.size() * sizeof(unsigned long long);
+	for (size_t l = 0; l < levels.size(); l++) {
+		table[2 * l] = offset;
+		table[2 * l + 1] = levels[l].size() / header.recordSize;
+		offset += levels[l].size();
+	}
+
+	bool ok = (fwrite(&header, sizeof(TileFileHeader), 1, f) == 1);
+	ok = ok && (table.empty() || fwrite(&table[0], table.size() * sizeof(unsigned long long), 1, f) == 1);
+	for (size_t l = 0; ok && l < levels.size(); l++) {
+		ok = (levels[l].empty() || fwrite(&levels[l][0], levels[l].size(), 1, f) == 1);
+	}
+
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		cout << "Error while writing file " << path << "." << endl;
+	return ok;
+}
+
+inline bool TileExporter::Export(const string dir, const uint prefixLevel, const uint maxLevel, const uint flags, const REAL * values)
+{
+	if ((flags & TILE_FILE_VALUES) && !values) {
+		cout << "ERROR: Values of points are required" << endl;
+		return false;
+	}
+	return ExportTiles(dir, prefixLevel, maxLevel, flags, values, NULL);
+}
+
+inline bool TileExporter::ExportAttribute(const string dir, const uint prefixLevel, const uint maxLevel, const uint attribute, const uint flags)
+{
+	PointCloud<2> * pc = sfc->GetPointCloud();
+	if (attribute >= pc->GetAttributeNum() || !pc->GetAttribute(attribute).IsOrdered()) {
+		cout << "ERROR: Attribute has to exist and to be ordered along SFC" << endl;
+		return false;
+	}
+	return ExportTiles(dir, prefixLevel, maxLevel, flags | TILE_FILE_VALUES, NULL, &pc->GetAttribute(attribute));
+}
+
+inline bool TileExporter::ExportTiles(const string dir, const uint prefixLevel, const uint maxLevel, const uint flags, const REAL * values, const AttributeColumn * column)
+{
+	const uint level = sfc->GetLevel();
+	if (prefixLevel > maxLevel || maxLevel > level) {
+		cout << "ERROR: Levels have to satisfy prefix level <= max. level <= " << level << endl;
+		return false;
+	}
+
+	const uint n = sfc->GetCodeNum();
+	const CODE * codes = sfc->GetCodes();
+	const CompressedCodes * cc = sfc->GetCompressedCodes();
+	const uint * indices = sfc->GetIndices();
+	const Point origin = sfc->GetFrame().origin;
+
+	TileFileHeader header;
+	header.type = sfc->GetType();
+	header.level = level;
+	header.flags = flags & (TILE_FILE_CENTROIDS | TILE_FILE_VALUES);
+	header.recordSize = TileFileHeader::RecordSize(header.flags);
+	header.origin[0] = origin.x;
+	header.origin[1] = origin.y;
+	header.smallHexSize = sfc->GetCellSize();
+
+	//Groups of points in cells of the prefix level found by binary search in the sorted codes
+	//(compressed codes are searched and decoded without decompressing the SFC)
+	const uint prefixShift = 3 * (level - prefixLevel);
+	vector<uint> groupFirst;
+	vector<CODE> groupCode;
+	for (uint first = 0; first < n;) {
+		groupFirst.push_back(first);
+		groupCode.push_back(sfc->GetCode(first));
+		const CODE next = ((groupCode.back() >> prefixShift) + 1) << prefixShift;
+		first = (uint)(cc ? cc->LowerBound(next) : lower_bound(codes + first, codes + n, next) - codes);
+	}
+	const uint groupNum = (uint)groupFirst.size();
+	groupFirst.push_back(n);
+
+	//Each group walks its codes once, a closed tile is merged into its parent
+	const uint levelNum = maxLevel - prefixLevel + 1;
+	vector<TileSum> groupSum(groupNum);
+	atomic<bool> ok(true);
+	ParallelFor(groupNum, [&](uint g) {
+		vector<vector<char> > tiles(levelNum);
+		vector<TileSum> open(levelNum);
+		vector<CODE> cells(levelNum);
+		const uint first = groupFirst[g];
+		const uint last = groupFirst[g + 1];
+		vector<CODE> decoded(cc ? CODE_BLOCK_SIZE : 0);
+
+		for (uint i = first; i <= last; i++) {
+			if (cc && i < last && (i == first || i % CODE_BLOCK_SIZE == 0))
+				cc->Decode(i, (last - i < CODE_BLOCK_SIZE - i % CODE_BLOCK_SIZE ? last - i : CODE_BLOCK_SIZE - i % CODE_BLOCK_SIZE), &decoded[i % CODE_BLOCK_SIZE]);
+			const CODE code = (i < last ? (cc ? decoded[i % CODE_BLOCK_SIZE] : codes[i]) : 0);
+
+			//Tiles of changed cells closed from the finest level
+			for (int k = (int)levelNum - 1; k >= 0; k--) {
+				const CODE cell = (i < last ? code >> (3 * (level - prefixLevel - k)) : 0);
+				if (i > first && i < last && cell == cells[k])
+					break;
+				if (i > first) {
+					AppendTile(tiles[k], cells[k], open[k], header.flags);
+					if (k > 0)
+						open[k - 1].Merge(open[k]);
+					else
+						groupSum[g] = open[k];
+				}
+				cells[k] = cell;
+				open[k].Reset();
+			}
+			if (i == last)
+				break;
+
+			//The point is added to the finest tile
+			TileSum & t = open[levelNum - 1];
+			const Point * p = sfc->GetSFCPoint(i);
+			t.count++;
+			t.sum[0] += p->x - origin.x;
+			t.sum[1] += p->y - origin.y;
+			if (header.flags & TILE_FILE_VALUES) {
+				const REAL v = (column ? column->GetOrdered(i) : values[indices[i]]);
+				t.valueSum += v;
+				t.valueMin = (v < t.valueMin ? v : t.valueMin);
+				t.valueMax = (v > t.valueMax ? v : t.valueMax);
+			}
+		}
+
+		//File named by the digits of the prefix
+		TileFileHeader h = header;
+		h.prefixLevel = prefixLevel;
+		h.prefix = groupCode[g] >> prefixShift;
+		h.firstLevel = prefixLevel;
+		h.levelNum = levelNum;
+		h.count = last - first;
+		string name(prefixLevel + 1, '0');
+		for (uint d = 0; d <= prefixLevel; d++) {
+			name[prefixLevel - d] = (char)('0' + ((h.prefix >> (3 * d)) & 7));
+		}
+		if (!WriteFile(dir + "/" + name + ".ngt", h, tiles))
+			ok = false;
+	}, threads);
+	fileNum = groupNum;
+
+	//Coarse levels merged from the groups
+	if (ok && prefixLevel > 0) {
+		vector<vector<char> > tiles(prefixLevel);
+		for (uint l = 0; l < prefixLevel; l++) {
+			const uint shift = 3 * (level - l);
+			TileSum t;
+			t.Reset();
+			for (uint g = 0; g < groupNum; g++) {
+				t.Merge(groupSum[g]);
+				if (g + 1 == groupNum || (groupCode[g] >> shift) != (groupCode[g + 1] >> shift)) {
+					AppendTile(tiles[l], groupCode[g] >> shift, t, header.flags);
+					t.Reset();
+				}
+			}
+		}
+		header.prefixLevel = TILE_FILE_ROOT;
+		header.firstLevel = 0;
+		header.levelNum = prefixLevel;
+		header.count = n;
+		ok = WriteFile(dir + "/root.ngt", header, tiles);
+		fileNum++;
+	}
+
+	return ok;
+}
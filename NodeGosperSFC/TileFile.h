@@ -0,0 +1,97 @@
+#pragma once
+
+// Copyright (c) 2019 Vojtech Uher, VSB - Technical University of Ostrava
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights  to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// This software corresponds to our academic research. If you use this implementation 
+// cite our corresponding academic paper as:
+//
+//	V. Uher, P. Gajdos, V. Snasel, Y.-C. Lai, and M. Radecky. Hierarchical Hexagonal 
+//	Clustering and Indexing. Symmetry-Basel, 11(6) : 731, Jun 2019.
+//
+
+
+#include <cstring>
+#include "common.h"
+
+/*
+File of hexagon tiles (cells of Node-Gosper SFC with their aggregates) written by TileExporter
+
+The header is followed by a table of levels (offset and number of tiles of each level, 2 x 8 bytes) \
+and by tiles of each level sorted by codes. A tile is a record of recordSize bytes (little-endian):
+- code of the cell (8 bytes, level + 1 digits of 3 bits)
+- number of points (8 bytes)
+- mean point in original coordinates (2 x 8 bytes) with TILE_FILE_CENTROIDS
+- sum, min. and max. of values of points (3 x 8 bytes) with TILE_FILE_VALUES
+*/
+
+#define TILE_FILE_MAGIC "NGTL"
+#define TILE_FILE_VERSION 1
+#define TILE_FILE_ROOT 0xFFFFFFFF //Prefix level of the root file holding the coarse levels
+#define TILE_FILE_CENTROIDS 1 //Flag of mean points of tiles
+#define TILE_FILE_VALUES 2 //Flag of aggregated values of tiles
+
+//Header of the tile file (128 bytes)
+struct TileFileHeader
+{
+	char magic[4]; //TILE_FILE_MAGIC
+	uint version; //TILE_FILE_VERSION
+	uint type; //Type of indexation pattern
+	uint level; //Index of max. level of recursion of the SFC
+	uint prefixLevel; //Level of the common prefix of the tiles (TILE_FILE_ROOT for the root file)
+	uint flags; //TILE_FILE_CENTROIDS, TILE_FILE_VALUES
+	CODE prefix; //Common prefix of the tiles (code of the cell of prefixLevel)
+	uint firstLevel; //Level of the first stored level of tiles
+	uint levelNum; //Number of stored levels
+	uint recordSize; //Size of a tile in bytes
+	uint reserved;
+	unsigned long long count; //Number of points in the tiles of one level
+	double origin[2]; //Center of the root Gosper island
+	double smallHexSize; //Size of hexagons of the deepest level of recursion
+	char padding[48];
+
+	TileFileHeader() {
+		memset(this, 0, sizeof(TileFileHeader));
+		memcpy(magic, TILE_FILE_MAGIC, 4);
+		version = TILE_FILE_VERSION;
+	}
+	/*
+	Returns size of a tile for the given flags
+	*/
+	static uint RecordSize(uint flags) {
+		return 16 + ((flags & TILE_FILE_CENTROIDS) ? 16 : 0) + ((flags & TILE_FILE_VALUES) ? 24 : 0);
+	}
+	/*
+	Returns true if the header and the table of levels are valid (the table follows the header)
+	*/
+	bool IsValid(unsigned long long fileSize) const {
+		if (memcmp(magic, TILE_FILE_MAGIC, 4) != 0 || version != TILE_FILE_VERSION || recordSize != RecordSize(flags) ||
+			levelNum > 64 || firstLevel + levelNum > level + 1 || fileSize < sizeof(TileFileHeader) + levelNum * 16ULL)
+			return false;
+		const unsigned long long * table = (const unsigned long long *)(this + 1);
+		for (uint l = 0; l < levelNum; l++) {
+			if (table[2 * l] > fileSize || table[2 * l + 1] > (fileSize - table[2 * l]) / recordSize)
+				return false;
+		}
+		return true;
+	}
+};
+
+static_assert(sizeof(TileFileHeader) == 128, "Unexpected size of TileFileHeader");
@@ -92,6 +92,13 @@ struct BB
 	Point min, max;
 };
 
+//Frame of an SFC
+struct Frame
+{
+	Point origin; //Center of the root
+	REAL radius; //Radius of the circle which fits into the root
+};
+
 #define SQR(x)((x)*(x)) //Square
 #define RND(x)( ((x)<0.0) ? ((int)((x) - 0.5)) : ((int)((x) + 0.5)) ) //Round
 